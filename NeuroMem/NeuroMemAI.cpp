@@ -47,6 +47,7 @@
 
 #include <NeuroMemAI.h>
 #include <NeuroMemSPI.h>
+#include <NeuroMemKnowledge.h>
 
 // Modules of the NeuroMem hardware (Byte #0 in map address)
 static const int mod_NM=0x01;
@@ -79,7 +80,26 @@ extern "C" {
   #include <stdint.h>
 }
 
-NeuroMemSPI spi;
+// ------------------------------------------------------------ 
+// Mark the start and the end of a function of NeuroMemAI in the
+// trace of the transport, see NeuroMemTrace.h. The functions it
+// calls are traced as part of it
+// ------------------------------------------------------------ 
+class TraceScope
+{
+	public:
+		TraceScope(NeuroMemTransport* bus, int &depth, const char* operation) : bus(bus), depth(depth)
+		{
+			if (depth++==0) bus->mark(operation);
+		}
+		~TraceScope()
+		{
+			if (--depth==0) bus->mark("");
+		}
+	private:
+		NeuroMemTransport* bus;
+		int &depth;
+};
 
 // ------------------------------------------------------------ //
 //    Constructor to the class NeuroMemAI
@@ -100,28 +120,74 @@ NeuroMemAI::NeuroMemAI(){
 
 int NeuroMemAI::begin(int Platform)
 {
+	TraceScope scope(bus, traceDepth, "begin");
 	int error=spi.connect(Platform);
-	if (error==0) 
+	if (error==0) error=beginPlatform(Platform);
+	return(error);
+}
+// ------------------------------------------------------------ 
+// Initialize the neural network of a platform wired on another
+// chip select or clocked at another speed, see NeuroMemSPI::connect
+// ------------------------------------------------------------ 
+int NeuroMemAI::begin(int Platform, int selectPin, long speed)
+{
+	TraceScope scope(bus, traceDepth, "begin");
+	int error=spi.connect(Platform, selectPin, speed);
+	if (error==0) error=beginPlatform(Platform);
+	return(error);
+}
+// ------------------------------------------------------------ 
+// Initialize the neural network of the platform detected
+// by NeuroMemSPI::detect, see spi.platform
+// ------------------------------------------------------------ 
+int NeuroMemAI::begin()
+{
+	TraceScope scope(bus, traceDepth, "begin");
+	int Platform=spi.detect();
+	if (Platform==0) return(1);
+	return(beginPlatform(Platform));
+}
+int NeuroMemAI::beginPlatform(int Platform)
+{
+	int error=begin(&spi);
+	switch(Platform)
 	{
-		countNeuronsAvailable(); // update the global navail
-		clearNeurons();
-		switch(Platform)
-		{
-			case HW_BRAINCARD: SD_select=SD_CS_BRAINCARD; break;
-			case HW_NEUROSHIELD: SD_select=SD_CS_NEUROSHIELD; break;
-			case HW_NEUROTILE: SD_select=SD_CS_NEUROTILE; break;
-		}
-		SD_detected=SD.begin(SD_select);
+		case HW_BRAINCARD: SD_select=SD_CS_BRAINCARD; break;
+		case HW_NEUROSHIELD: SD_select=SD_CS_NEUROSHIELD; break;
+		case HW_NEUROTILE: SD_select=SD_CS_NEUROTILE; break;
 	}
+	SD_detected=SD.begin(SD_select);
 	return(error);
 }
 // ------------------------------------------------------------ 
+// Initialize the neural network accessed through another transport,
+// for example a software model of the network on a host computer.
+// The transport must be ready, and the SD card is initialized
+// on the first call to save or load a knowledge
+// ------------------------------------------------------------ 
+int NeuroMemAI::begin(NeuroMemTransport* transport)
+{
+	bus=transport;
+	TraceScope scope(bus, traceDepth, "begin");
+	regCached=false; // until clearNeurons sets all the control registers
+	// verify the default MINIF value to detect the network
+	if (bus->read(mod_NM, NM_MINIF)!=2) return(1);
+	countNeuronsAvailable(); // update the global navail
+	clearNeurons();
+	return(0);
+}
+// ------------------------------------------------------------ 
 // Un-commit all the neurons, so they all become ready to learn
 // Reset the Maximum Influence Field to default value=0x4000
 // ------------------------------------------------------------ 
 void NeuroMemAI::forget()
 {
-	spi.write(mod_NM, NM_FORGET, 0);
+	TraceScope scope(bus, traceDepth, "forget");
+	bus->write(mod_NM, NM_FORGET, 0);
+	forgetRegisters();
+	generation++;
+	KN_savedCount=-1;
+	clearShadow();
 }
 // ------------------------------------------------------------ 
 // Un-commit all the neurons, so they all become ready to learn,
@@ -129,8 +195,13 @@ void NeuroMemAI::forget()
 // ------------------------------------------------------------ 
 void NeuroMemAI::forget(int Maxif)
 {
-	spi.write(mod_NM, NM_FORGET, 0);
-	spi.write(mod_NM, NM_MAXIF, Maxif);
+	TraceScope scope(bus, traceDepth, "forget");
+	bus->write(mod_NM, NM_FORGET, 0);
+	forgetRegisters();
+	writeRegister(NM_MAXIF, Maxif);
+	generation++;
+	KN_savedCount=-1;
+	clearShadow();
 }
 // --------------------------------------------------------------
 // Clear the memory of the neurons to the value 0
@@ -138,15 +209,89 @@ void NeuroMemAI::forget(int Maxif)
 // --------------------------------------------------------------
 void NeuroMemAI::clearNeurons()
 {
-	spi.write(mod_NM, NM_NSR, 16);
-	spi.write(mod_NM, NM_TESTCAT, 0x0001);
-	spi.write(mod_NM, NM_NSR, 0);
+	TraceScope scope(bus, traceDepth, "clearNeurons");
+	writeRegister(NM_NSR, 16);
+	bus->write(mod_NM, NM_TESTCAT, 0x0001);
+	writeRegister(NM_NSR, 0);
 	for (int i=0; i< NEURONSIZE; i++)
 	{
-		spi.write(mod_NM, NM_INDEXCOMP,i);
-		spi.write(mod_NM, NM_TESTCOMP,0);
+		bus->write(mod_NM, NM_INDEXCOMP,i);
+		bus->write(mod_NM, NM_TESTCOMP,0);
+	}
+	bus->write(mod_NM, NM_FORGET,0);
+	forgetRegisters();
+	regCached=true; // NSR has been written too
+	KN_savedCount=-1;
+	clearShadow();
+}
+// ------------------------------------------------------------ 
+// Read the control registers cached by NeuroMemAI (GCR, MINIF,
+// MAXIF and the mode bits of NSR) after a reset of the network
+// or after registers were written without this class
+// ------------------------------------------------------------ 
+void NeuroMemAI::resync()
+{
+	TraceScope scope(bus, traceDepth, "resync");
+	regNSR=bus->read(mod_NM, NM_NSR) & 0x30;
+	regGCR=bus->read(mod_NM, NM_GCR);
+	regMAXIF=bus->read(mod_NM, NM_MAXIF);
+	if (regNSR & 0x10)
+	{
+		// MINIF is the one of the pointed neuron in SR mode
+		bus->write(mod_NM, NM_NSR, regNSR & 0x20);
+		regMINIF=bus->read(mod_NM, NM_MINIF);
+		bus->write(mod_NM, NM_NSR, regNSR);
+	}
+	else regMINIF=bus->read(mod_NM, NM_MINIF);
+	regCached=true;
+	generation++;
+}
+// ------------------------------------------------------------ 
+// Write a control register, unless the cache shows that
+// it already holds this value. A new context or mode starts
+// a new generation, since the responses of the neurons change
+// ------------------------------------------------------------ 
+void NeuroMemAI::writeRegister(int reg, int value)
+{
+	int* cached=0;
+	switch(reg)
+	{
+		case NM_GCR: cached=&regGCR; break;
+		case NM_MINIF: cached=&regMINIF; break;
+		case NM_MAXIF: cached=&regMAXIF; break;
+		case NM_NSR: cached=&regNSR; value&=0x30; break; // mode bits, the others are read only
+	}
+	if ((regCached) && (cached!=0) && (*cached==value)) return;
+	bus->write(mod_NM, reg, value);
+	if (cached!=0) *cached=value;
+	if ((reg==NM_GCR) || (reg==NM_NSR)) generation++;
+}
+// ------------------------------------------------------------ 
+// Read a control register from the cache, or from the network
+// until the cache is valid
+// ------------------------------------------------------------ 
+int NeuroMemAI::readRegister(int reg)
+{
+	if (regCached)
+	{
+		switch(reg)
+		{
+			case NM_GCR: return(regGCR);
+			case NM_MINIF: return(regMINIF);
+			case NM_MAXIF: return(regMAXIF);
+			case NM_NSR: return(regNSR);
+		}
 	}
-	spi.write(mod_NM, NM_FORGET,0);
+	return(bus->read(mod_NM, reg));
+}
+// ------------------------------------------------------------ 
+// FORGET resets GCR=1, MINIF=2 and MAXIF=0x4000
+// ------------------------------------------------------------ 
+void NeuroMemAI::forgetRegisters()
+{
+	regGCR=1;
+	regMINIF=2;
+	regMAXIF=0x4000;
 }
 // ------------------------------------------------------------ 
 // Detect the capacity of the NeuroMem network
@@ -154,41 +299,90 @@ void NeuroMemAI::clearNeurons()
 // ------------------------------------------------------------ 
 int NeuroMemAI::countNeuronsAvailable()
 {
-	spi.write(mod_NM, NM_FORGET, 0);
-	spi.write(mod_NM, NM_NSR, 0x0010);
-	spi.write(mod_NM, NM_TESTCAT, 0x0001);
-	spi.write(mod_NM, NM_RESETCHAIN, 0);
-	int read_cat;	
+	TraceScope scope(bus, traceDepth, "countNeuronsAvailable");
+	bus->write(mod_NM, NM_FORGET, 0);
+	writeRegister(NM_NSR, 0x0010);
+	bus->write(mod_NM, NM_TESTCAT, 0x0001);
+	bus->write(mod_NM, NM_RESETCHAIN, 0);
 	navail = 0;
-	while (1) {
-		read_cat = spi.read(mod_NM, NM_CAT);
-		if (read_cat == 0xFFFF)
-			break;
-		navail++;
-	}
-	spi.write(mod_NM, NM_NSR, 0x0000);
-	spi.write(mod_NM, NM_FORGET, 0);
+	if (burst)
+	{
+		// read the CAT of 32 neurons per Read_Addr command, 2 bytes per neuron
+		int cats[32];
+		bool end=false;
+		while (!end)
+		{
+			bus->readAddr(((long)mod_NM << 24) + NM_CAT, 32, cats);
+			for (int i=0; (i<32) && (!end); i++)
+			{
+				if (cats[i]==0xFFFF) end=true;
+				else navail++;
+			}
+		}
+	}
+	else
+	{
+		while (bus->read(mod_NM, NM_CAT)!=0xFFFF) navail++;
+	}
+	writeRegister(NM_NSR, 0x0000);
+	bus->write(mod_NM, NM_FORGET, 0);
+	forgetRegisters();
+	// the neurons are forgotten, as with forget()
+	generation++;
+	KN_savedCount=-1;
+	clearShadow();
 	return(navail);
 }
 // --------------------------------------------------------
 // Broadcast a vector to the neurons and return the recognition status
 // 0= unknown, 4=uncertain, 8=Identified
+// In burst mode, the length-1 first components are streamed to the COMP
+// register with a single Write_Addr command (8 + 2*(length-1) bytes)
+// instead of one 10-byte register write per component
+// The components must be 0-255: the burst sends the vector as it is,
+// where the register writes keep the lower byte of each component
 //---------------------------------------------------------
 int NeuroMemAI::broadcast(int vector[], int length)
 {
-	//spi.writeAddr(0x01000001, length-1, vector);
-	for (int i=0; i<length-1;i++) spi.write(mod_NM, NM_COMP, vector[i] & 0x00FF);
-	spi.write(mod_NM, NM_LCOMP, vector[length-1]);
-	return(spi.read(mod_NM, NM_NSR));
+	TraceScope scope(bus, traceDepth, "broadcast");
+	sendVector(vector, length);
+	return(bus->read(mod_NM, NM_NSR));
+}
+void NeuroMemAI::sendVector(int vector[], int length)
+{
+	if ((burst) && (length > 1))
+	{
+		bus->writeAddr(((long)mod_NM << 24) + NM_COMP, length-1, vector);
+	}
+	else
+	{
+		for (int i=0; i<length-1;i++) bus->write(mod_NM, NM_COMP, vector[i] & 0x00FF);
+	}
+	bus->write(mod_NM, NM_LCOMP, vector[length-1]);
 }
 //-----------------------------------------------
 // Learn a vector using the current context value
 //----------------------------------------------
 int NeuroMemAI::learn(int vector[], int length, int category)
 {
-	broadcast(vector, length);
-	spi.write(mod_NM, NM_CAT,category);
-	return(spi.read(mod_NM, NM_NCOUNT));
+	TraceScope scope(bus, traceDepth, "learn");
+	int nsr=broadcast(vector, length);
+	generation++;
+	int ncount=-1;
+	if (nsr & 0x08) ncount=bus->read(mod_NM, NM_NCOUNT);
+	bus->write(mod_NM, NM_CAT,category);
+	int newcount=bus->read(mod_NM, NM_NCOUNT);
+	// the firing neurons of another category have shrunk their AIF:
+	// uncertain, counter-example, or identified with another category
+	// which committed a new neuron or could not in a full network
+	if ((nsr & 0x24) || ((nsr & 0x08) && ((category==0) || (newcount!=ncount) || (newcount>=navail))))
+	{
+		KN_compact=true;
+		shadowStale=true;
+		shadowDirty=true;
+	}
+	if ((newcount > shadowCount) && (shadowCount < shadowCapacity)) shadowDirty=true;
+	return(newcount);
 }
 // ---------------------------------------------------------
 // Classify a vector and return its classification status
@@ -198,8 +392,8 @@ int NeuroMemAI::learn(int vector[], int length, int category)
 // ---------------------------------------------------------
 int NeuroMemAI::classify(int vector[], int length)
 {
-	broadcast(vector, length);
-	return(spi.read(mod_NM, NM_NSR));
+	TraceScope scope(bus, traceDepth, "classify");
+	return(broadcast(vector, length));
 }
 //----------------------------------------------
 // Recognize a vector and return the best match, or the 
@@ -207,11 +401,12 @@ int NeuroMemAI::classify(int vector[], int length)
 //----------------------------------------------
 int NeuroMemAI::classify(int vector[], int length, int* distance, int* category, int* nid)
 {
-	broadcast(vector, length);
-	*distance = spi.read(mod_NM, NM_DIST);
-	*category= spi.read(mod_NM, NM_CAT); //remark : Bit15 = degenerated flag, true value = bit[14:0]
-	*nid =spi.read(mod_NM, NM_NID);
-	return(spi.read(mod_NM, NM_NSR));
+	TraceScope scope(bus, traceDepth, "classifyBest");
+	int nsr=broadcast(vector, length);
+	*distance = bus->read(mod_NM, NM_DIST);
+	*category= bus->read(mod_NM, NM_CAT); //remark : Bit15 = degenerated flag, true value = bit[14:0]
+	*nid =bus->read(mod_NM, NM_NID);
+	return(nsr); // reading DIST, CAT and NID does not change the status
 }
 //----------------------------------------------
 // Recognize a vector and return the response  of up to K top firing neurons
@@ -221,11 +416,77 @@ int NeuroMemAI::classify(int vector[], int length, int* distance, int* category,
 //----------------------------------------------
 int NeuroMemAI::classify(int vector[], int length, int K, int distance[], int category[], int nid[])
 {
-	int recoNbr=0;
+	TraceScope scope(bus, traceDepth, "classifyK");
 	broadcast(vector, length);
+	return(readResponses(K, distance, category, nid));
+}
+//----------------------------------------------
+// Learn count vectors of length components, stored one after
+// the other in vectors, with their categories, in the current
+// context. Each vector takes its components, a CAT write and no
+// read: the status and NCOUNT are not read between the vectors,
+// so the neurons saved or mirrored are considered modified.
+// Return the number of committed neurons
+//----------------------------------------------
+int NeuroMemAI::learnBatch(int vectors[], int count, int length, int categories[])
+{
+	TraceScope scope(bus, traceDepth, "learnBatch");
+	writeRegister(NM_NSR, readRegister(NM_NSR) & 0x20); // out of SR mode, once
+	for (int i=0; i<count; i++)
+	{
+		sendVector(&vectors[(long)i * length], length);
+		bus->write(mod_NM, NM_CAT, categories[i]);
+	}
+	if (count > 0)
+	{
+		generation++;
+		KN_compact=true;
+		shadowStale=true;
+		shadowDirty=true;
+	}
+	return(bus->read(mod_NM, NM_NCOUNT));
+}
+//----------------------------------------------
+// Classify count vectors of length components, stored one after
+// the other in vectors, in the current context and mode, and return
+// the top firing neuron of each one, as classify. The status of each
+// vector is read only if status is not null, and the category and
+// identifier only if a neuron fires.
+// Return the number of vectors recognized
+//----------------------------------------------
+int NeuroMemAI::classifyBatch(int vectors[], int count, int length, int distance[], int category[], int nid[], int status[])
+{
+	TraceScope scope(bus, traceDepth, "classifyBatch");
+	writeRegister(NM_NSR, readRegister(NM_NSR) & 0x20); // out of SR mode, once
+	int recognized=0;
+	for (int i=0; i<count; i++)
+	{
+		sendVector(&vectors[(long)i * length], length);
+		if (status!=0) status[i]=bus->read(mod_NM, NM_NSR);
+		distance[i]=bus->read(mod_NM, NM_DIST);
+		if (distance[i]==0xFFFF)
+		{
+			category[i]=0xFFFF;
+			nid[i]=0xFFFF;
+		}
+		else
+		{
+			recognized++;
+			category[i]=bus->read(mod_NM, NM_CAT); //remark : Bit15 = degenerated flag, true value = bit[14:0]
+			nid[i]=bus->read(mod_NM, NM_NID);
+		}
+	}
+	return(recognized);
+}
+//----------------------------------------------
+// Read the response of up to K top firing neurons after a broadcast
+//----------------------------------------------
+int NeuroMemAI::readResponses(int K, int distance[], int category[], int nid[])
+{
+	int recoNbr=0;
 	for (int i=0; i<K; i++)
 	{
-		distance[i] = spi.read(mod_NM, NM_DIST);
+		distance[i] = bus->read(mod_NM, NM_DIST);
 		if (distance[i]==0xFFFF)
 		{ 
 			category[i]=0xFFFF;
@@ -234,51 +495,122 @@ int NeuroMemAI::classify(int vector[], int length, int K, int distance[], int ca
 		else
 		{
 			recoNbr++;
-			category[i]= spi.read(mod_NM, NM_CAT); //remark : Bit15 = degenerated flag, true value = bit[14:0]
-			nid[i] =spi.read(mod_NM, NM_NID);
+			category[i]= bus->read(mod_NM, NM_CAT); //remark : Bit15 = degenerated flag, true value = bit[14:0]
+			nid[i] =bus->read(mod_NM, NM_NID);
 		}
 	}
 return(recoNbr);
 }
+//----------------------------------------------
+// Split-phase classification: beginClassify starts to send the
+// length-1 first components and returns, possibly before the end
+// of the transfer if the transport sends them by DMA or interrupt
+// (see NeuroMemTransport::startWriteAddr). The vector must stay
+// unchanged and the neurons must not be accessed until finishClassify,
+// which writes the last component and reads the response.
+// Return 1 if a classification is already in progress
+//----------------------------------------------
+int NeuroMemAI::beginClassify(int vector[], int length)
+{
+	TraceScope scope(bus, traceDepth, "beginClassify");
+	if (classifyPending) return(1);
+	if ((burst) && (length > 1))
+	{
+		bus->startWriteAddr(((long)mod_NM << 24) + NM_COMP, length-1, vector);
+	}
+	else
+	{
+		for (int i=0; i<length-1;i++) bus->write(mod_NM, NM_COMP, vector[i] & 0x00FF);
+	}
+	pendingLast=vector[length-1];
+	classifyPending=true;
+	return(0);
+}
+//----------------------------------------------
+// Return true when the components sent by beginClassify
+// have been transferred, and finishClassify does not wait
+//----------------------------------------------
+bool NeuroMemAI::isReady()
+{
+	return(bus->done());
+}
+//----------------------------------------------
+// Wait for the transfer started by beginClassify and return
+// the status and the top firing neuron, as classify.
+// Return 0 (unknown) and 0xFFFF if no classification was started
+//----------------------------------------------
+int NeuroMemAI::finishClassify(int* distance, int* category, int* nid)
+{
+	TraceScope scope(bus, traceDepth, "finishClassify");
+	if (!classifyPending)
+	{
+		*distance=0xFFFF; *category=0xFFFF; *nid=0xFFFF;
+		return(0);
+	}
+	while (!bus->done());
+	classifyPending=false;
+	bus->write(mod_NM, NM_LCOMP, pendingLast);
+	int nsr=bus->read(mod_NM, NM_NSR);
+	*distance = bus->read(mod_NM, NM_DIST);
+	*category= bus->read(mod_NM, NM_CAT); //remark : Bit15 = degenerated flag, true value = bit[14:0]
+	*nid =bus->read(mod_NM, NM_NID);
+	return(nsr);
+}
+//----------------------------------------------
+// Wait for the transfer started by beginClassify and return
+// the response of up to K top firing neurons, as classify.
+// Return 0 if no classification was started
+//----------------------------------------------
+int NeuroMemAI::finishClassify(int K, int distance[], int category[], int nid[])
+{
+	TraceScope scope(bus, traceDepth, "finishClassifyK");
+	if (!classifyPending) return(0);
+	while (!bus->done());
+	classifyPending=false;
+	bus->write(mod_NM, NM_LCOMP, pendingLast);
+	return(readResponses(K, distance, category, nid));
+}
 // ------------------------------------------------------------ 
 // Set a context and associated minimum and maximum influence fields
 // ------------------------------------------------------------ 
 void NeuroMemAI::setContext(int context, int minif, int maxif)
 {
+	TraceScope scope(bus, traceDepth, "setContext");
 	// context[15-8]= unused
 	// context[7]= Norm (0 for L1; 1 for LSup)
 	// context[6-0]= Active context value
-	spi.write(mod_NM, NM_GCR, context);
-	spi.write(mod_NM, NM_MINIF, minif);
-	spi.write(mod_NM, NM_MAXIF, maxif);
+	writeRegister(NM_GCR, context);
+	writeRegister(NM_MINIF, minif);
+	writeRegister(NM_MAXIF, maxif);
 }
 // ------------------------------------------------------------ 
 // Get a context and associated minimum and maximum influence fields
 // ------------------------------------------------------------ 
 void NeuroMemAI::getContext(int* context, int* minif, int* maxif)
 {
+	TraceScope scope(bus, traceDepth, "getContext");
 	// context[15-8]= unused
 	// context[7]= Norm (0 for L1; 1 for LSup)
 	// context[6-0]= Active context value
-	*context = spi.read(mod_NM, NM_GCR);
-	*minif= spi.read(mod_NM, NM_MINIF); 
-	*maxif =spi.read(mod_NM, NM_MAXIF);
+	*context = readRegister(NM_GCR);
+	*minif= readRegister(NM_MINIF); 
+	*maxif =readRegister(NM_MAXIF);
 }
 // --------------------------------------------------------
 // Set the neurons in Radial Basis Function mode (default)
 //---------------------------------------------------------
 void NeuroMemAI::setRBF()
 {
-	int tempNSR=spi.read(mod_NM, NM_NSR);
-	spi.write(mod_NM, NM_NSR, tempNSR & 0xDF);
+	TraceScope scope(bus, traceDepth, "setRBF");
+	writeRegister(NM_NSR, readRegister(NM_NSR) & 0xDF);
 }
 // --------------------------------------------------------
 // Set the neurons in K-Nearest Neighbor mode
 //---------------------------------------------------------
 void NeuroMemAI::setKNN()
 {
-	int tempNSR=spi.read(mod_NM, NM_NSR);
-	spi.write(mod_NM, NM_NSR, tempNSR | 0x20);
+	TraceScope scope(bus, traceDepth, "setKNN");
+	writeRegister(NM_NSR, readRegister(NM_NSR) | 0x20);
 }
 //-------------------------------------------------------------
 // Read the contents of the neuron pointed by index in the chain of neurons
@@ -286,19 +618,30 @@ void NeuroMemAI::setKNN()
 //-------------------------------------------------------------
 void NeuroMemAI::readNeuron(int nid, int model[], int* context, int* aif, int* category)
 {
-	int TempNSR=spi.read(mod_NM, NM_NSR);
-	spi.write(mod_NM, NM_NSR, 0x10);
-	spi.write(mod_NM, NM_RESETCHAIN, 0);
+	TraceScope scope(bus, traceDepth, "readNeuron");
+	refreshShadow();
+	if ((shadow!=0) && (nid>=0) && (nid < shadowCount))
+	{
+		uint8_t* record=shadow + (long)nid * SHADOW_NEURON;
+		*context=NeuroMemKnowledge::get16(record);
+		*aif=NeuroMemKnowledge::get16(record + 2);
+		*category=NeuroMemKnowledge::get16(record + 6);
+		for (int j=0; j<NEURONSIZE; j++) model[j]=record[NeuroMemKnowledge::REGISTERS_SIZE + j];
+		return;
+	}
+	int TempNSR=readRegister(NM_NSR);
+	writeRegister(NM_NSR, 0x10);
+	bus->write(mod_NM, NM_RESETCHAIN, 0);
 	if (nid>0)
 	{
 		 // move to index in the chain of neurons
-		 for (int i=0; i<nid; i++) spi.read(mod_NM, NM_CAT);
+		 for (int i=0; i<nid; i++) bus->read(mod_NM, NM_CAT);
 	}
-	*context=spi.read(mod_NM, NM_NCR);
-	for (int j=0; j<NEURONSIZE; j++) model[j]=spi.read(mod_NM, NM_COMP);
-	*aif=spi.read(mod_NM, NM_AIF);
-	*category=spi.read(mod_NM, NM_CAT);
-	spi.write(mod_NM, NM_NSR, TempNSR); // set the NN back to its calling status
+	*context=bus->read(mod_NM, NM_NCR);
+	readComponents(model);
+	*aif=bus->read(mod_NM, NM_AIF);
+	*category=bus->read(mod_NM, NM_CAT);
+	writeRegister(NM_NSR, TempNSR); // set the NN back to its calling status
 }
 //-------------------------------------------------------------
 // Read the contents of the neuron pointed by index in the chain of neurons
@@ -309,20 +652,23 @@ void NeuroMemAI::readNeuron(int nid, int model[], int* context, int* aif, int* c
 //-------------------------------------------------------------
 void NeuroMemAI::readNeuron(int nid, int neuron[])
 {
-	int TempNSR=spi.read(mod_NM, NM_NSR);
-	spi.write(mod_NM, NM_NSR, 0x10);
-	spi.write(mod_NM, NM_RESETCHAIN, 0);
+	TraceScope scope(bus, traceDepth, "readNeuron");
+	refreshShadow();
+	if ((shadow!=0) && (nid>=0) && (nid < shadowCount))
+	{
+		readShadow(nid, neuron);
+		return;
+	}
+	int TempNSR=readRegister(NM_NSR);
+	writeRegister(NM_NSR, 0x10);
+	bus->write(mod_NM, NM_RESETCHAIN, 0);
 	if (nid>0)
 	{
 		 // move to index in the chain of neurons
-		 for (int i=0; i<nid; i++) spi.read(mod_NM, NM_CAT);
+		 for (int i=0; i<nid; i++) bus->read(mod_NM, NM_CAT);
 	}
-	neuron[0]=spi.read(mod_NM, NM_NCR);
-	for (int j=0; j<NEURONSIZE; j++) neuron[j+1]=spi.read(mod_NM, NM_COMP);
-	neuron[NEURONSIZE+1]=spi.read(mod_NM, NM_AIF);
-	neuron[NEURONSIZE+2]=spi.read(mod_NM, NM_MINIF);
-	neuron[NEURONSIZE+3]=spi.read(mod_NM, NM_CAT);
-	spi.write(mod_NM, NM_NSR, TempNSR); // set the NN back to its calling status
+	readNeuronData(neuron);
+	writeRegister(NM_NSR, TempNSR); // set the NN back to its calling status
 }
 //----------------------------------------------------------------------------
 // Read the contents of the committed neurons
@@ -333,22 +679,26 @@ void NeuroMemAI::readNeuron(int nid, int neuron[])
 //----------------------------------------------------------------------------
 int NeuroMemAI::readNeurons(int neurons[])
 {
-	int ncount= spi.read(mod_NM, NM_NCOUNT);
-	int TempNSR=spi.read(mod_NM, NM_NSR); // save value to restore upon exit
-	spi.write(mod_NM, NM_NSR, 0x0010);
-	spi.write(mod_NM, NM_RESETCHAIN, 0);
+	TraceScope scope(bus, traceDepth, "readNeurons");
+	refreshShadow();
+	int ncount= bus->read(mod_NM, NM_NCOUNT);
+	if ((shadow!=0) && (ncount <= shadowCount))
+	{
+		// all the committed neurons are mirrored
+		for (int i=0; i< ncount; i++) readShadow(i, &neurons[i * (NEURONSIZE + 4)]);
+		return(ncount);
+	}
+	int TempNSR=readRegister(NM_NSR); // save value to restore upon exit
+	writeRegister(NM_NSR, 0x0010);
+	bus->write(mod_NM, NM_RESETCHAIN, 0);
 	int offset=0;
 	int recLen=NEURONSIZE+4; // memory plus 4 int of neuron registers	
 	for (int i=0; i< ncount; i++)
 	{
-		neurons[offset]=spi.read(mod_NM, NM_NCR);
-		for (int j=0; j< NEURONSIZE; j++) neurons[offset + 1 + j]=spi.read(mod_NM, NM_COMP);
-		neurons[offset + NEURONSIZE + 1]=spi.read(mod_NM, NM_AIF);
-		neurons[offset + NEURONSIZE + 2]=spi.read(mod_NM, NM_MINIF);
-		neurons[offset + NEURONSIZE + 3]=spi.read(mod_NM, NM_CAT);
+		readNeuronData(&neurons[offset]);
 		offset+=recLen;
 	}
-	spi.write(mod_NM, NM_NSR, TempNSR); // set the NN back to its calling status
+	writeRegister(NM_NSR, TempNSR); // set the NN back to its calling status
 	return(ncount);
 }
 
@@ -361,24 +711,155 @@ int NeuroMemAI::readNeurons(int neurons[])
 //---------------------------------------------------------------------
 void NeuroMemAI::writeNeurons(int neurons[], int ncount)
 {
-	int TempNSR=spi.read(mod_NM, NM_NSR); // save value to restore NN upon exit
-	int TempGCR=spi.read(mod_NM, NM_GCR);
+	TraceScope scope(bus, traceDepth, "writeNeurons");
+	int TempNSR=readRegister(NM_NSR); // save value to restore NN upon exit
+	int TempGCR=readRegister(NM_GCR);
 	clearNeurons();
-	spi.write(mod_NM, NM_NSR, 0x0010);
-	spi.write(mod_NM, NM_RESETCHAIN, 0);		
+	writeRegister(NM_NSR, 0x0010);
+	bus->write(mod_NM, NM_RESETCHAIN, 0);		
 	int offset=0;
 	int recLen=NEURONSIZE+4;	
 	for (int i=0; i< ncount; i++)
 	{	
-		spi.write(mod_NM, NM_NCR, neurons[offset]);
-		for (int j=0; j<NEURONSIZE; j++) spi.write(mod_NM, NM_COMP, neurons[offset+1+j]);
-		spi.write(mod_NM, NM_AIF,neurons[offset + NEURONSIZE + 1]);
-		spi.write(mod_NM, NM_MINIF, neurons[offset + NEURONSIZE+ 2]);	
-		spi.write(mod_NM, NM_CAT, neurons[offset + NEURONSIZE+ 3]);
+		writeNeuronData(&neurons[offset]);
 		offset+=recLen;
 	}
-	spi.write(mod_NM, NM_NSR, TempNSR); // set the NN back to its calling status
-	spi.write(mod_NM, NM_GCR, TempGCR);
+	writeRegister(NM_NSR, TempNSR); // set the NN back to its calling status
+	writeRegister(NM_GCR, TempGCR);
+}
+
+//-------------------------------------------------------------
+// Read the NEURONSIZE components of the neuron pointed in the chain
+// The chain must be in Save and Restore mode (NSR=0x10)
+// In burst mode, the components are read with a single Read_Addr
+// command on the COMP register instead of NEURONSIZE register reads
+//-------------------------------------------------------------
+void NeuroMemAI::readComponents(int model[])
+{
+	if (burst)
+	{
+		bus->readAddr(((long)mod_NM << 24) + NM_COMP, NEURONSIZE, model);
+	}
+	else
+	{
+		for (int j=0; j<NEURONSIZE; j++) model[j]=bus->read(mod_NM, NM_COMP);
+	}
+}
+//-------------------------------------------------------------
+// Read the neuron pointed in the chain and move to the next one
+// The chain must be in Save and Restore mode (NSR=0x10)
+// Output format: NCR, NEURONSIZE * COMP, AIF, MINIF, CAT
+// Burst mode: 5 SPI transactions per neuron instead of NEURONSIZE + 4
+//-------------------------------------------------------------
+void NeuroMemAI::readNeuronData(int neuron[])
+{
+	neuron[0]=bus->read(mod_NM, NM_NCR);
+	readComponents(&neuron[1]);
+	neuron[NEURONSIZE+1]=bus->read(mod_NM, NM_AIF);
+	neuron[NEURONSIZE+2]=bus->read(mod_NM, NM_MINIF);
+	neuron[NEURONSIZE+3]=bus->read(mod_NM, NM_CAT); // reading CAT moves to the next neuron
+}
+//-------------------------------------------------------------
+// Write the neuron pointed in the chain and move to the next one
+// The chain must be in Save and Restore mode (NSR=0x10)
+// Input format: NCR, NEURONSIZE * COMP, AIF, MINIF, CAT
+// Only the length first components are written
+// Burst mode: 5 SPI transactions per neuron instead of NEURONSIZE + 4
+//-------------------------------------------------------------
+void NeuroMemAI::writeNeuronData(int neuron[], int length)
+{
+	bus->write(mod_NM, NM_NCR, neuron[0]);
+	if ((burst) && (length > 0))
+	{
+		bus->writeAddr(((long)mod_NM << 24) + NM_COMP, length, &neuron[1]);
+	}
+	else
+	{
+		for (int j=0; j<length; j++) bus->write(mod_NM, NM_COMP, neuron[1+j]);
+	}
+	bus->write(mod_NM, NM_AIF, neuron[NEURONSIZE + 1]);
+	bus->write(mod_NM, NM_MINIF, neuron[NEURONSIZE + 2]);
+	bus->write(mod_NM, NM_CAT, neuron[NEURONSIZE + 3]); // writing CAT commits the neuron and moves to the next one
+	if ((shadow!=0) && (!shadowDirty) && (shadowCount < shadowCapacity))
+	{
+		// the components after length are null after clearNeurons
+		uint8_t* record=shadow + (long)shadowCount * SHADOW_NEURON;
+		NeuroMemKnowledge::packNeuron(neuron, NEURONSIZE, 0, record);
+		for (int j=length; j<NEURONSIZE; j++) record[NeuroMemKnowledge::REGISTERS_SIZE + j]=0;
+		shadowCount++;
+	}
+}
+
+//-------------------------------------------------------------
+// Mirror the committed neurons in a buffer of size bytes in
+// RAM or memory-mapped PSRAM, SHADOW_NEURON bytes per neuron.
+// readNeuron, readNeurons and the knowledge saves are then
+// served from the buffer without SPI traffic.
+// Return the number of neurons the buffer can hold.
+// A null buffer stops the mirroring
+// The shadow follows learn, loadKnowledge_SDcard, writeNeurons and
+// forget, but not the writes to the neuron registers in Save and
+// Restore mode
+//-------------------------------------------------------------
+int NeuroMemAI::setShadow(uint8_t buffer[], long size)
+{
+	shadow=buffer;
+	shadowCapacity=(buffer==0) ? 0 : (int)(size / SHADOW_NEURON);
+	shadowCount=0;
+	shadowDirty=true; // the neurons are copied on the first access
+	shadowStale=false;
+	return(shadowCapacity);
+}
+void NeuroMemAI::clearShadow()
+{
+	shadowCount=0;
+	shadowDirty=false;
+	shadowStale=false;
+}
+//-------------------------------------------------------------
+// Update the shadow after some learning with a single walk of
+// the chain: the AIF and CAT of the mirrored neurons if they may
+// have shrunk, then the neurons committed since the last update
+//-------------------------------------------------------------
+void NeuroMemAI::refreshShadow()
+{
+	if ((shadow==0) || (!shadowDirty)) return;
+	int ncount=bus->read(mod_NM, NM_NCOUNT);
+	if (ncount > shadowCapacity) ncount=shadowCapacity;
+	if (shadowCount > ncount) shadowCount=ncount;
+	int neuron[NEURONSIZE + 4];
+	int TempNSR=readRegister(NM_NSR);
+	writeRegister(NM_NSR, 0x10);
+	bus->write(mod_NM, NM_RESETCHAIN, 0);
+	uint8_t* record=shadow;
+	for (int i=0; i< ncount; i++)
+	{
+		if (i >= shadowCount)
+		{
+			readNeuronData(neuron);
+			NeuroMemKnowledge::packNeuron(neuron, NEURONSIZE, 0, record);
+		}
+		else if (shadowStale)
+		{
+			NeuroMemKnowledge::put16(record + 2, bus->read(mod_NM, NM_AIF));
+			NeuroMemKnowledge::put16(record + 6, bus->read(mod_NM, NM_CAT));
+		}
+		else bus->read(mod_NM, NM_CAT); // reading CAT moves to the next neuron
+		record+=SHADOW_NEURON;
+	}
+	writeRegister(NM_NSR, TempNSR); // set the NN back to its calling status
+	shadowCount=ncount;
+	shadowDirty=false;
+	shadowStale=false;
+}
+//-------------------------------------------------------------
+// Read a mirrored neuron, format NCR, NEURONSIZE * COMP, AIF, MINIF, CAT
+//-------------------------------------------------------------
+void NeuroMemAI::readShadow(int index, int neuron[])
+{
+	uint8_t* record=shadow + (long)index * SHADOW_NEURON;
+	NeuroMemKnowledge::unpackRegisters(record, NEURONSIZE, 0, neuron);
+	NeuroMemKnowledge::unpackComponents(record + NeuroMemKnowledge::REGISTERS_SIZE, NEURONSIZE, NEURONSIZE, neuron);
 }
 
 // --------------------------------------------------------
@@ -386,29 +867,30 @@ void NeuroMemAI::writeNeurons(int neurons[], int ncount)
 //---------------------------------------------------------
 int NeuroMemAI::NCOUNT()
 {
-	return(spi.read(mod_NM, NM_NCOUNT));
+	return(bus->read(mod_NM, NM_NCOUNT));
 }
 // --------------------------------------------------------
 // Get/Set the Minimum Influence Field register
 //---------------------------------------------------------
 void NeuroMemAI::MINIF(int value)
 {
-	spi.write(mod_NM, NM_MINIF, value);
+	if ((regCached) && (regNSR & 0x10)) bus->write(mod_NM, NM_MINIF, value); // MINIF of the pointed neuron
+	else writeRegister(NM_MINIF, value);
 }
 int NeuroMemAI::MINIF()
 {
-	return(spi.read(mod_NM, NM_MINIF));
+	return(bus->read(mod_NM, NM_MINIF));
 }
 // --------------------------------------------------------
 // Get/Set the Maximum Influence Field register
 //---------------------------------------------------------
 void NeuroMemAI::MAXIF(int value)
 {
-	spi.write(mod_NM, NM_MAXIF, value);
+	writeRegister(NM_MAXIF, value);
 }
 int NeuroMemAI::MAXIF()
 {
-	return(spi.read(mod_NM, NM_MAXIF));
+	return(bus->read(mod_NM, NM_MAXIF));
 }
 // --------------------------------------------------------
 // Get/Set the Global Context register
@@ -418,36 +900,42 @@ void NeuroMemAI::GCR(int value)
 	// GCR[15-8]= unused
 	// GCR[7]= Norm (0 for L1; 1 for LSup)
 	// GCR[6-0]= Active context value
-	spi.write(mod_NM, NM_GCR, value);
+	writeRegister(NM_GCR, value);
 }
 int NeuroMemAI::GCR()
 {
-	return(spi.read(mod_NM, NM_GCR));
+	return(bus->read(mod_NM, NM_GCR));
 }
 // --------------------------------------------------------
 // Get/Set the Category register
 //---------------------------------------------------------
 void NeuroMemAI::CAT(int value)
 {
-	spi.write(mod_NM, NM_CAT, value);
+	bus->write(mod_NM, NM_CAT, value);
+	generation++; // learning, or a neuron written in SR mode
 }
 int NeuroMemAI::CAT()
 {
-	return(spi.read(mod_NM, NM_CAT));
+	return(bus->read(mod_NM, NM_CAT));
 }
 // --------------------------------------------------------
 // Get the Distance register
 //---------------------------------------------------------
 int NeuroMemAI::DIST()
 {	
-	return(spi.read(mod_NM, NM_DIST));
+	return(bus->read(mod_NM, NM_DIST));
 }
 // --------------------------------------------------------
-// Set the Component Index register
+// Set the Component Index register, or get the identifier
+// of the firing neuron after a DIST and CAT read
 //---------------------------------------------------------
 void NeuroMemAI::NID(int value)
 {
-	spi.write(mod_NM, NM_NID, value);
+	bus->write(mod_NM, NM_NID, value);
+}
+int NeuroMemAI::NID()
+{
+	return(bus->read(mod_NM, NM_NID));
 }
 // --------------------------------------------------------
 // Get/Set the Network Status register
@@ -458,70 +946,71 @@ void NeuroMemAI::NID(int value)
 //---------------------------------------------------------
 void NeuroMemAI::NSR(int value)
 {
-	spi.write(mod_NM, NM_NSR, value);
+	writeRegister(NM_NSR, value);
 }
 int NeuroMemAI::NSR()
 {
-	return(spi.read(mod_NM, NM_NSR));
+	return(bus->read(mod_NM, NM_NSR));
 }
 // --------------------------------------------------------
 // Get/Set the AIF register
 //---------------------------------------------------------
 void NeuroMemAI::AIF(int value)
 {
-	spi.write(mod_NM, NM_AIF, value);
+	bus->write(mod_NM, NM_AIF, value);
 }
 int NeuroMemAI::AIF()
 {
-	return(spi.read(mod_NM, NM_AIF));
+	return(bus->read(mod_NM, NM_AIF));
 }
 // --------------------------------------------------------
 // Reset the chain to first neuron in SR Mode
 //---------------------------------------------------------
 void NeuroMemAI::RESETCHAIN()
 {
-	spi.write(mod_NM, NM_RESETCHAIN, 0);
+	bus->write(mod_NM, NM_RESETCHAIN, 0);
 }
 // --------------------------------------------------------
 // Get/Set the NCR register
 //---------------------------------------------------------
 void NeuroMemAI::NCR(int value)
 {
-	spi.write(mod_NM, NM_NCR, value);
+	bus->write(mod_NM, NM_NCR, value);
 }
 int NeuroMemAI::NCR()
 {
-	return(spi.read(mod_NM, NM_NCR));
+	return(bus->read(mod_NM, NM_NCR));
 }
 // --------------------------------------------------------
 // Get/Set the COMP register (component)
 //---------------------------------------------------------
 void NeuroMemAI::COMP(int value)
 {
-	spi.write(mod_NM, NM_COMP, value);
+	bus->write(mod_NM, NM_COMP, value);
 }
 int NeuroMemAI::COMP()
 {
-	return(spi.read(mod_NM, NM_COMP));
+	return(bus->read(mod_NM, NM_COMP));
 }
 // --------------------------------------------------------
 // Get/Set the LCOMP register (last component)
 //---------------------------------------------------------
 void NeuroMemAI::LCOMP(int value)
 {
-	spi.write(mod_NM, NM_LCOMP, value);
+	bus->write(mod_NM, NM_LCOMP, value);
 }
 int NeuroMemAI::LCOMP()
 {
-	return(spi.read(mod_NM, NM_LCOMP));
+	return(bus->read(mod_NM, NM_LCOMP));
 }
 
 // --------------------------------------------------------
 // Save the knowledge of the neurons to a knowledge file
-// saved in a format compatible with the NeuroMem API
+// saved in the V2 format, see NeuroMemKnowledge.h
 // --------------------------------------------------------
 int NeuroMemAI::saveKnowledge_SDcard(char* filename)
 {
+	TraceScope scope(bus, traceDepth, "saveKnowledge");
 	if (!SD_detected)
 	{
 		SD_detected=SD.begin(SD_select);
@@ -531,39 +1020,223 @@ int NeuroMemAI::saveKnowledge_SDcard(char* filename)
     File SDfile = SD.open(filename, FILE_WRITE);
     if(! SDfile) return(3);
 
-    int header[4]{ KN_FORMAT, 0,0,0 };
-    header[1] = NEURONSIZE;
+	int flags=KN_usedLength ? NeuroMemKnowledge::FLAG_USEDLEN : 0;
     int ncount = NCOUNT();
-    header[2]=ncount;
-    int* p_myheader = header;
-    byte* b_myheader = (byte*)p_myheader;    
-    SDfile.write(b_myheader, sizeof(int)*4);
+	uint8_t header[NeuroMemKnowledge::HEADER_SIZE];
+	NeuroMemKnowledge::packHeader(header, NEURONSIZE, ncount, flags);
+    SDfile.write(header, NeuroMemKnowledge::HEADER_SIZE);
 
     int neuron[NEURONSIZE + 4];
-    int* p_myneuron = neuron;
-    byte* b_myneuron = (byte*)p_myneuron;
-	int TempNSR=spi.read(mod_NM, NM_NSR);
-	spi.write(mod_NM, NM_NSR, 0x10);
-	spi.write(mod_NM, NM_RESETCHAIN, 0);
+	uint8_t record[NeuroMemKnowledge::REGISTERS_SIZE + 2 + NEURONSIZE];
+	uint32_t checksum=0;
+	refreshShadow();
+	bool mirrored=(shadow!=0) && (ncount <= shadowCount);
+	int TempNSR=readRegister(NM_NSR);
+	writeRegister(NM_NSR, 0x10);
+	bus->write(mod_NM, NM_RESETCHAIN, 0);
 	for (int i=0; i< ncount; i++)
 	{
-		neuron[0]=spi.read(mod_NM, NM_NCR);
-		for (int j=0; j<NEURONSIZE; j++) neuron[j+1]=spi.read(mod_NM, NM_COMP);
-		neuron[NEURONSIZE+1]=spi.read(mod_NM, NM_AIF);
-		neuron[NEURONSIZE+2]=spi.read(mod_NM, NM_MINIF);
-		neuron[NEURONSIZE+3]=spi.read(mod_NM, NM_CAT);		     
-		SDfile.write(b_myneuron, sizeof(int)*(NEURONSIZE + 4));
+		if (mirrored) readShadow(i, neuron);
+		else readNeuronData(neuron);
+		int recLen=NeuroMemKnowledge::packNeuron(neuron, NEURONSIZE, flags, record);
+		checksum=NeuroMemKnowledge::checksum(checksum, record, recLen);
+		SDfile.write(record, recLen);
 	}
-	spi.write(mod_NM, NM_NSR, TempNSR); // set the NN back to its calling status	
+	writeRegister(NM_NSR, TempNSR); // set the NN back to its calling status	
+	NeuroMemKnowledge::put32(record, checksum);
+	SDfile.write(record, NeuroMemKnowledge::CHECKSUM_SIZE);
     SDfile.close();
+	KN_savedCount=ncount;
+	KN_savedChecksum=checksum;
+	KN_savedFlags=flags;
+	KN_compact=false;
 	return(0); 
 }
 // --------------------------------------------------------
+// Update a knowledge file written by saveKnowledge_SDcard or
+// checkpointKnowledge_SDcard with the neurons committed since
+// The new neurons are appended, and the neuron count of the
+// header and the checksum are updated in place
+// The file is rewritten if a learning has modified the AIF
+// of saved neurons, or if it is not the last file saved
+// --------------------------------------------------------
+int NeuroMemAI::checkpointKnowledge_SDcard(char* filename)
+{
+	TraceScope scope(bus, traceDepth, "checkpointKnowledge");
+	int flags=KN_usedLength ? NeuroMemKnowledge::FLAG_USEDLEN : 0;
+	if ((KN_compact) || (KN_savedCount < 0) || (flags!=KN_savedFlags)) return(saveKnowledge_SDcard(filename));
+	if (!SD_detected)
+	{
+		SD_detected=SD.begin(SD_select);
+	}
+	if (!SD_detected) return(1);
+	int ncount=NCOUNT();
+	if (ncount < KN_savedCount) return(saveKnowledge_SDcard(filename));
+	if (!SD.exists(filename)) return(saveKnowledge_SDcard(filename));
+	File SDfile = SD.open(filename, O_READ | O_WRITE); // FILE_WRITE would append the header
+	if (!SDfile) return(3);
+
+	// the file must hold the last saved neurons
+	uint8_t record[NeuroMemKnowledge::REGISTERS_SIZE + 2 + NEURONSIZE];
+	int neuronSize=0, fileFlags=0;
+	long fileCount=0;
+	uint32_t end=SDfile.size() - NeuroMemKnowledge::CHECKSUM_SIZE;
+	bool same=(SDfile.read(record, NeuroMemKnowledge::HEADER_SIZE)==NeuroMemKnowledge::HEADER_SIZE)
+		&& (NeuroMemKnowledge::unpackHeader(record, &neuronSize, &fileCount, &fileFlags)==NeuroMemKnowledge::FORMAT_V2)
+		&& (neuronSize==NEURONSIZE) && (fileFlags==flags) && (fileCount==KN_savedCount)
+		&& (SDfile.seek(end)) && (SDfile.read(record, NeuroMemKnowledge::CHECKSUM_SIZE)==NeuroMemKnowledge::CHECKSUM_SIZE)
+		&& (NeuroMemKnowledge::get32(record)==KN_savedChecksum);
+	if (!same)
+	{
+		SDfile.close();
+		return(saveKnowledge_SDcard(filename));
+	}
+	if (ncount==KN_savedCount)
+	{
+		SDfile.close();
+		return(0);
+	}
+
+	int neuron[NEURONSIZE + 4];
+	uint32_t checksum=KN_savedChecksum;
+	refreshShadow();
+	bool mirrored=(shadow!=0) && (ncount <= shadowCount);
+	int TempNSR=readRegister(NM_NSR);
+	writeRegister(NM_NSR, 0x10);
+	bus->write(mod_NM, NM_RESETCHAIN, 0);
+	if (!mirrored)
+	{
+		for (int i=0; i< KN_savedCount; i++) bus->read(mod_NM, NM_CAT); // reading CAT moves to the next neuron
+	}
+	SDfile.seek(end);
+	for (int i=KN_savedCount; i< ncount; i++)
+	{
+		if (mirrored) readShadow(i, neuron);
+		else readNeuronData(neuron);
+		int recLen=NeuroMemKnowledge::packNeuron(neuron, NEURONSIZE, flags, record);
+		checksum=NeuroMemKnowledge::checksum(checksum, record, recLen);
+		SDfile.write(record, recLen);
+	}
+	writeRegister(NM_NSR, TempNSR); // set the NN back to its calling status
+	NeuroMemKnowledge::put32(record, checksum);
+	SDfile.write(record, NeuroMemKnowledge::CHECKSUM_SIZE);
+	NeuroMemKnowledge::put32(record, ncount);
+	SDfile.seek(4); // ncount in the header
+	SDfile.write(record, 4);
+	SDfile.close();
+	KN_savedCount=ncount;
+	KN_savedChecksum=checksum;
+	return(0);
+}
+// --------------------------------------------------------
+// Sequential reader of a knowledge file by chunks of
+// KN_CHUNK bytes, alternating between two buffers.
+// When a buffer is released, it is refilled with the chunk
+// following the other buffer, so the records are decoded
+// from memory and the SD card is read by whole chunks
+// --------------------------------------------------------
+class KnowledgeReader
+{
+	public:
+		KnowledgeReader(File &file) : file(file)
+		{
+			size[0]=fill(0);
+			size[1]=fill(1);
+		}
+		// point data to at most n bytes of the current chunk
+		// and return their number, 0 at the end of the file
+		int next(const uint8_t** data, int n)
+		{
+			if (pos==size[current])
+			{
+				if (size[current] < NeuroMemAI::KN_CHUNK) return(0);
+				size[current]=fill(current);
+				current^=1;
+				pos=0;
+			}
+			int count=size[current] - pos;
+			if (n < count) count=n;
+			*data=buffer[current] + pos;
+			pos+=count;
+			return(count);
+		}
+		// copy n bytes and return the number of bytes copied
+		int read(uint8_t dest[], int n)
+		{
+			int done=0;
+			const uint8_t* data;
+			while (done < n)
+			{
+				int count=next(&data, n - done);
+				if (count==0) break;
+				for (int i=0; i<count; i++) dest[done + i]=data[i];
+				done+=count;
+			}
+			return(done);
+		}
+	private:
+		File &file;
+		uint8_t buffer[2][NeuroMemAI::KN_CHUNK];
+		int size[2];
+		int current=0;
+		int pos=0;
+		int fill(int b)
+		{
+			int count=file.read(buffer[b], NeuroMemAI::KN_CHUNK);
+			return(count < 0 ? 0 : count);
+		}
+};
+// --------------------------------------------------------
+// Read a neuron of a V1 knowledge file saved with int of
+// width bytes
+// --------------------------------------------------------
+static bool readNeuronV1(KnowledgeReader &reader, int neuron[], int neuronSize, int width)
+{
+	uint8_t value[4];
+	for (int i=0; i<neuronSize + 4; i++)
+	{
+		if (reader.read(value, width)!=width) return(false);
+		neuron[i]=NeuroMemKnowledge::get16(value);
+	}
+	return(true);
+}
+// --------------------------------------------------------
+// Read a neuron record of a V2 knowledge file, update the
+// checksum and return the number of components, -1 if
+// the file is truncated
+// --------------------------------------------------------
+static int readNeuronV2(KnowledgeReader &reader, int neuron[], int neuronSize, int flags, uint32_t* checksum)
+{
+	uint8_t registers[NeuroMemKnowledge::REGISTERS_SIZE + 2];
+	int recHeader=NeuroMemKnowledge::recordHeaderSize(flags);
+	if (reader.read(registers, recHeader)!=recHeader) return(-1);
+	*checksum=NeuroMemKnowledge::checksum(*checksum, registers, recHeader);
+	int length=NeuroMemKnowledge::unpackRegisters(registers, neuronSize, flags, neuron);
+	const uint8_t* comps;
+	for (int j=0; j<length; )
+	{
+		int count=reader.next(&comps, length - j);
+		if (count==0) return(-1);
+		*checksum=NeuroMemKnowledge::checksum(*checksum, comps, count);
+		for (int i=0; i<count; i++) neuron[1 + j + i]=comps[i];
+		j+=count;
+	}
+	return(length);
+}
+// --------------------------------------------------------
 // Load the neurons with a knowledge stored in a knowledge file
-// saved in a format compatible with the NeuroMem API
+// saved in the V1 or V2 format, see NeuroMemKnowledge.h
+// V1 files can be read whatever the int size of the platform
+// which saved them
+// The file is read by chunks of KN_CHUNK bytes and exactly
+// ncount neurons are written. KN_loadRate reports the
+// throughput of the load in neurons per second
 // --------------------------------------------------------
 int NeuroMemAI::loadKnowledge_SDcard(char* filename)
 {
+	TraceScope scope(bus, traceDepth, "loadKnowledge");
+	unsigned long start=micros();
+	KN_loadRate=0;
 	if (!SD_detected)
 	{
 		SD_detected=SD.begin(SD_select);
@@ -572,39 +1245,81 @@ int NeuroMemAI::loadKnowledge_SDcard(char* filename)
 	if (!SD.exists(filename)) return(2); 
     File SDfile = SD.open(filename, FILE_READ);
     if (!SDfile) return(3);
-	
-    int header[4];
-    int* p_myheader = header;
-    byte* b_myheader = (byte*)p_myheader;    
-    SDfile.read(b_myheader, sizeof(int)*4);  
-    if (header[0] < KN_FORMAT) return(4);
-    if (header[1] > NEURONSIZE) return(5);
-	int ncount=0;    
-    if (header[2] > navail)return(6); 
-		else ncount=header[2]; // incompatible neuron size
-		
+
+	uint8_t header[NeuroMemKnowledge::HEADER_SIZE];
+	int format=0, neuronSize=0, flags=0, width=0;
+	long ncount=0;
+	if (SDfile.read(header, 4)==4)
+	{
+		format=NeuroMemKnowledge::get16(header);
+		if (format==NeuroMemKnowledge::FORMAT_V2)
+		{
+			SDfile.read(header + 4, NeuroMemKnowledge::HEADER_SIZE - 4);
+			NeuroMemKnowledge::unpackHeader(header, &neuronSize, &ncount, &flags);
+		}
+		else if (format==NeuroMemKnowledge::FORMAT_V1)
+		{
+			// int header[4]= { KN_FORMAT, NEURONSIZE, ncount, 0 }
+			// the upper bytes of header[0] are null if int has 4 bytes
+			width=(NeuroMemKnowledge::get16(header + 2)==0) ? 4 : 2;
+			SDfile.read(header + 4, 4 * width - 4);
+			neuronSize=NeuroMemKnowledge::get16(header + width);
+			ncount=NeuroMemKnowledge::get16(header + 2 * width);
+		}
+	}
+	int error=0;
+    if ((format!=NeuroMemKnowledge::FORMAT_V1) && (format!=NeuroMemKnowledge::FORMAT_V2)) error=4;
+    else if (neuronSize > NEURONSIZE) error=5; // incompatible neuron size
+    else if (ncount > navail) error=6;
+	if (error!=0)
+	{
+		SDfile.close();
+		return(error);
+	}
+
+	KnowledgeReader reader(SDfile);
     int neuron[NEURONSIZE + 4];
-    int* p_myneuron = neuron;
-    byte* b_myneuron = (byte*)p_myneuron; 
-    while(SDfile.available())
-	{
-		int TempGCR=spi.read(mod_NM, NM_GCR);
-		int TempNSR=spi.read(mod_NM, NM_NSR); // save value to restore NN upon exit	
-		clearNeurons();
-		spi.write(mod_NM, NM_NSR, 0x0010);
-		spi.write(mod_NM, NM_RESETCHAIN, 0);		
-		for (int i=0; i<ncount; i++)
+	uint32_t checksum=0;
+	int TempGCR=readRegister(NM_GCR);
+	int TempNSR=readRegister(NM_NSR); // save value to restore NN upon exit	
+	clearNeurons();
+	writeRegister(NM_NSR, 0x0010);
+	bus->write(mod_NM, NM_RESETCHAIN, 0);		
+	long i;
+	for (i=0; i<ncount; i++)
+	{
+		int length=neuronSize;
+		if (format==NeuroMemKnowledge::FORMAT_V1)
+		{
+			if (!readNeuronV1(reader, neuron, neuronSize, width)) break;
+		}
+		else
+		{
+			length=readNeuronV2(reader, neuron, neuronSize, flags, &checksum);
+			if (length < 0) break;
+		}
+		// registers after the components of the file
+		if (neuronSize < NEURONSIZE)
 		{
-			SDfile.read(b_myneuron, sizeof(int)*(NEURONSIZE + 4));
-			spi.write(mod_NM, NM_NCR, neuron[0]);
-			for (int j=0; j<NEURONSIZE; j++) spi.write(mod_NM, NM_COMP, neuron[1+j]);
-			spi.write(mod_NM, NM_AIF,neuron[NEURONSIZE + 1]);
-			spi.write(mod_NM, NM_MINIF, neuron[NEURONSIZE+ 2]);	
-			spi.write(mod_NM, NM_CAT, neuron[NEURONSIZE+ 3]);
+			for (int j=3; j>=1; j--) neuron[NEURONSIZE + j]=neuron[neuronSize + j];
 		}
-		spi.write(mod_NM, NM_NSR, TempNSR); // set the NN back to its calling status
-		spi.write(mod_NM, NM_GCR, TempGCR);
-	}		
+		writeNeuronData(neuron, length); // the other components are null after clearNeurons
+	}
+	writeRegister(NM_NSR, TempNSR); // set the NN back to its calling status
+	writeRegister(NM_GCR, TempGCR);
+	if (i < ncount) error=7; // truncated file
+	else if (format==NeuroMemKnowledge::FORMAT_V2)
+	{
+		if ((reader.read(header, NeuroMemKnowledge::CHECKSUM_SIZE)!=NeuroMemKnowledge::CHECKSUM_SIZE)
+			|| (NeuroMemKnowledge::get32(header)!=checksum)) error=7;
+	}
 	SDfile.close();
+	if (error!=0)
+	{
+		forget(); // discard a corrupted knowledge
+		return(error);
+	}
+	unsigned long elapsed=micros() - start;
+	KN_loadRate=(long)(ncount * 1000000.0 / (elapsed > 0 ? elapsed : 1));
 	return(0); 
-}
\ No newline at end of file
+}
@@ -7,6 +7,7 @@
 #ifndef _NeuroMemAI_h_
 #define _NeuroMemAI_h_
 
+#include "NeuroMemTransport.h"
 #include "NeuroMemSPI.h"
 
 extern "C" {
@@ -18,31 +19,49 @@ class NeuroMemAI
 	public:
 				
 		static const int NEURONSIZE=256; //memory capacity of each neuron in byte		
-		static const int KN_FORMAT=0x1704; // version number for the save neuron file format
+		static const int KN_FORMAT=0x1704; // version number of the V1 knowledge file format, see NeuroMemKnowledge.h
 		int navail=0; // initialized during the begin function
+		bool burst=true; // broadcast with Write_Addr bursts, false for one SPI write per component
+		unsigned long generation=0; // changes with the neurons, the context or the mode, see NeuroMemResultCache.h
+		
+		NeuroMemSPI spi; // SPI link to the BrainCard, NeuroShield or NeuroTile
+		NeuroMemTransport* bus=&spi; // transport used to access the neurons
 		
 		NeuroMemAI();
+		int begin();
 		int begin(int Platform);
+		int begin(int Platform, int selectPin, long speed);
+		int begin(NeuroMemTransport* transport);
 		void forget();
 		void forget(int Maxif);
 		void clearNeurons();
 		int countNeuronsAvailable();
+		void resync();
 		
 		void setContext(int context, int minif, int maxif);
 		void getContext(int* context, int* minif, int* maxif);
 		void setRBF();
 		void setKNN();
 		
-		int broadcast(int vector[], int length);
+		int broadcast(int vector[], int length); // components 0-255, see NeuroMemAI.cpp
 		int learn(int vector[], int length, int category);
 		int classify(int vector[], int length);
 		int classify(int vector[], int length, int* distance, int* category, int* nid);
 		int classify(int vector[], int length, int K, int distance[], int category[], int nid[]);
+		int learnBatch(int vectors[], int count, int length, int categories[]);
+		int classifyBatch(int vectors[], int count, int length, int distance[], int category[], int nid[], int status[]=0);
+		int beginClassify(int vector[], int length);
+		bool isReady();
+		int finishClassify(int* distance, int* category, int* nid);
+		int finishClassify(int K, int distance[], int category[], int nid[]);
 
 		void readNeuron(int nid, int model[], int* context, int* aif, int* category);
 		void readNeuron(int nid, int neuron[]);
 		int readNeurons(int neurons[]);
 		void writeNeurons(int neurons[], int ncount);
+
+		static const int SHADOW_NEURON=8 + NEURONSIZE; // bytes per neuron in a shadow buffer
+		int setShadow(uint8_t buffer[], long size);
 	
 		//--------------------------
 		// NeuroMem register access
@@ -65,6 +84,7 @@ class NeuroMemAI
 		void CAT(int value);
 		int CAT();
 		void NID(int value);
+		int NID();
 		int DIST();
 		void RESETCHAIN();
 		void NCR(int value);
@@ -81,7 +101,42 @@ class NeuroMemAI
 		//-----------------------------------
 		int SD_select=0;
 		bool SD_detected=false;
+		bool KN_usedLength=true; // save the used length of each neuron, smaller files for short vectors
+		static const int KN_CHUNK=128; // bytes per SD read when loading a knowledge, two buffers
+		long KN_loadRate=0; // neurons per second of the last loadKnowledge_SDcard
 		int saveKnowledge_SDcard(char* filename);
 		int loadKnowledge_SDcard(char* filename);
+		int checkpointKnowledge_SDcard(char* filename);
+		long KN_savedCount=-1; // neurons in the last knowledge file saved, -1 if the neurons were cleared since
+		bool KN_compact=false; // a learning modified saved neurons, the next checkpoint rewrites the file
+
+	private:
+		int traceDepth=0; // functions in progress, see NeuroMemTrace.h
+		int beginPlatform(int Platform);
+		void readComponents(int model[]);
+		void sendVector(int vector[], int length);
+		int readResponses(int K, int distance[], int category[], int nid[]);
+		bool classifyPending=false; // components sent by beginClassify
+		int pendingLast=0; // last component, written by finishClassify
+		void readNeuronData(int neuron[]);
+		void writeNeuronData(int neuron[], int length=NEURONSIZE);
+		uint32_t KN_savedChecksum=0;
+		int KN_savedFlags=0;
+		uint8_t* shadow=0; // copy of the committed neurons, see setShadow
+		int shadowCapacity=0;
+		int shadowCount=0; // neurons copied in the shadow
+		bool shadowDirty=false; // learning since the last copy
+		bool shadowStale=false; // the AIF of copied neurons may have shrunk
+		void clearShadow();
+		void refreshShadow();
+		void readShadow(int index, int neuron[]);
+		bool regCached=false; // the control registers below match the network, see resync
+		int regGCR=1;
+		int regMINIF=2;
+		int regMAXIF=0x4000;
+		int regNSR=0; // mode bits only
+		void writeRegister(int reg, int value);
+		int readRegister(int reg);
+		void forgetRegisters();
 };
 #endif
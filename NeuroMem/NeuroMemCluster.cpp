@@ -0,0 +1,146 @@
+/************************************************************************/
+/*
+ *	NeuroMemCluster.cpp	--	Several NeuroMem devices used as one network
+ *
+ */
+/******************************************************************************/
+
+#include <NeuroMemCluster.h>
+
+int NeuroMemCluster::add(NeuroMemAI* device)
+{
+	if (ndevices==MAX_DEVICES) return(1);
+	devices[ndevices++]=device;
+	updateActive();
+	return(0);
+}
+// ------------------------------------------------------------
+// The active device is the first one which is not full
+// ------------------------------------------------------------
+void NeuroMemCluster::updateActive()
+{
+	for (active=0; active < ndevices-1; active++)
+	{
+		if (devices[active]->NCOUNT() < devices[active]->navail) break;
+	}
+}
+long NeuroMemCluster::offset(int device)
+{
+	long first=0;
+	for (int i=0; i<device; i++) first+=devices[i]->navail;
+	return(first);
+}
+long NeuroMemCluster::navail()
+{
+	return(offset(ndevices));
+}
+long NeuroMemCluster::ncount()
+{
+	long count=0;
+	for (int i=0; i<ndevices; i++) count+=devices[i]->NCOUNT();
+	return(count);
+}
+void NeuroMemCluster::forget()
+{
+	for (int i=0; i<ndevices; i++) devices[i]->forget();
+	active=0;
+}
+void NeuroMemCluster::setContext(int context, int minif, int maxif)
+{
+	for (int i=0; i<ndevices; i++) devices[i]->setContext(context, minif, maxif);
+}
+void NeuroMemCluster::setRBF()
+{
+	for (int i=0; i<ndevices; i++) devices[i]->setRBF();
+}
+void NeuroMemCluster::setKNN()
+{
+	for (int i=0; i<ndevices; i++) devices[i]->setKNN();
+}
+// ------------------------------------------------------------
+// Learn a vector: the full devices reduce the influence field of
+// their firing neurons of another category, the active device
+// can also commit a new neuron
+// ------------------------------------------------------------
+long NeuroMemCluster::learn(int vector[], int length, int category)
+{
+	if (ndevices==0) return(0);
+	for (int i=0; i<active; i++) devices[i]->learn(vector, length, category);
+	long first=offset(active);
+	int count=devices[active]->learn(vector, length, category);
+	if ((count >= devices[active]->navail) && (active < ndevices-1)) active++;
+	return(first + count);
+}
+// ------------------------------------------------------------
+// Recognize a vector and return the best match of all the devices
+// The status is uncertain if a device is uncertain, or if the
+// devices identify the vector with different categories
+// ------------------------------------------------------------
+int NeuroMemCluster::classify(int vector[], int length, int* distance, int* category, int* nid)
+{
+	int status=0;
+	*distance=0xFFFF; *category=0xFFFF; *nid=0xFFFF;
+	for (int i=0; i<ndevices; i++)
+	{
+		int d, c, n;
+		int nsr=devices[i]->classify(vector, length, &d, &c, &n) & 0x0C;
+		if (nsr==0) continue;
+		if (nsr & 0x04) status=0x04;
+		else if (status==0) status=0x08;
+		else if ((status==0x08) && ((c & 0x7FFF)!=(*category & 0x7FFF))) status=0x04;
+		n=(int)(n + offset(i));
+		if ((d < *distance) || ((d==*distance) && ((c & 0x7FFF) < (*category & 0x7FFF))))
+		{
+			*distance=d; *category=c; *nid=n;
+		}
+	}
+	return(status);
+}
+// ------------------------------------------------------------
+// Recognize a vector and return the response of up to K top firing
+// neurons of all the devices
+// ------------------------------------------------------------
+int NeuroMemCluster::classify(int vector[], int length, int K, int distance[], int category[], int nid[])
+{
+	int n=0;
+	for (int i=0; i<ndevices; i++)
+	{
+		devices[i]->broadcast(vector, length);
+		n=merge(i, K, distance, category, nid, n);
+	}
+	for (int i=n; i<K; i++)
+	{
+		distance[i]=0xFFFF; category[i]=0xFFFF; nid[i]=0xFFFF;
+	}
+	return(n);
+}
+// ------------------------------------------------------------
+// Insert the firing neurons of a device in the n sorted responses,
+// the device reads them out by increasing distance, category and
+// identifier, so the readout stops at the first one which is
+// further than the K-th response
+// ------------------------------------------------------------
+int NeuroMemCluster::merge(int device, int K, int distance[], int category[], int nid[], int n)
+{
+	NeuroMemAI* nm=devices[device];
+	long first=offset(device);
+	for (int k=0; k<K; k++)
+	{
+		int d=nm->DIST();
+		if (d==0xFFFF) break;
+		if ((n==K) && (d > distance[K-1])) break;
+		int c=nm->CAT();
+		int id=(int)(nm->NID() + first);
+		int j=n;
+		while ((j > 0) && ((d < distance[j-1]) || ((d==distance[j-1]) && (((c & 0x7FFF) < (category[j-1] & 0x7FFF))
+			|| (((c & 0x7FFF)==(category[j-1] & 0x7FFF)) && (id < nid[j-1])))))) j--;
+		if (j==K) break;
+		for (int i=(n < K ? n : K-1); i > j; i--)
+		{
+			distance[i]=distance[i-1]; category[i]=category[i-1]; nid[i]=nid[i-1];
+		}
+		distance[j]=d; category[j]=c; nid[j]=id;
+		if (n < K) n++;
+	}
+	return(n);
+}
@@ -0,0 +1,69 @@
+/************************************************************************/
+/*
+ *	NeuroMemCluster.h	--	Several NeuroMem devices used as one network
+ *
+ *  Each device is a NeuroMemAI initialized on its own chip select and
+ *  clock, for example two NeuroShields on the same SPI bus:
+ *
+ *    NeuroMemAI nm1, nm2;
+ *    NeuroMemCluster cluster;
+ *    nm1.begin(2, 7, 2000000);
+ *    nm2.begin(2, 4, 2000000);
+ *    cluster.add(&nm1);
+ *    cluster.add(&nm2);
+ *
+ *  The devices are filled in the order they were added: learn commits the
+ *  new neurons on the first device which is not full (active), and the
+ *  full devices before it learn the vector too, so their firing neurons of
+ *  another category reduce their influence field, without committing.
+ *  The influence field of a new neuron only takes into account the neurons
+ *  of its device, and a vector recognized by a full device can still commit
+ *  a neuron on the active device.
+ *
+ *  classify broadcasts the vector to each device and merges the responses
+ *  by distance, then category, then identifier. The identifier of a neuron
+ *  is its identifier on its device plus the capacity of the devices before
+ *  it, as in a single chain of neurons.
+ *
+ *  The devices share the SPI bus, so the bus time of a classification is
+ *  the sum of the bus time of each device, while the capacity adds up.
+ */
+/******************************************************************************/
+#ifndef _NeuroMemCluster_h_
+#define _NeuroMemCluster_h_
+
+#include "NeuroMemAI.h"
+
+class NeuroMemCluster
+{
+	public:
+
+		static const int MAX_DEVICES=8;
+
+		NeuroMemAI* devices[MAX_DEVICES];
+		int ndevices=0;
+		int active=0; // device which commits the new neurons
+
+		// add a device initialized by begin, return 1 if the cluster is full
+		int add(NeuroMemAI* device);
+		long navail(); // neurons of all the devices
+		long ncount(); // committed neurons
+		void forget();
+		void setContext(int context, int minif, int maxif);
+		void setRBF();
+		void setKNN();
+
+		// return the number of committed neurons
+		long learn(int vector[], int length, int category);
+		// return the status of the network: 0= unknown, 4=uncertain, 8=Identified
+		int classify(int vector[], int length, int* distance, int* category, int* nid);
+		// return the number of firing neurons or K whichever is smaller
+		int classify(int vector[], int length, int K, int distance[], int category[], int nid[]);
+
+	private:
+
+		void updateActive();
+		long offset(int device); // identifier of the first neuron of the device, minus 1
+		int merge(int device, int K, int distance[], int category[], int nid[], int n);
+};
+#endif
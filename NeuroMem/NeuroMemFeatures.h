@@ -0,0 +1,231 @@
+/************************************************************************/
+/*
+ *	NeuroMemFeatures.h	--	Feature extraction from the lines of a camera
+ *
+ *  The extractors consume the frame one line at a time, as read in burst
+ *  from the FIFO of the ArduCAM (RGB565, 2 bytes per pixel, MSB first),
+ *  and accumulate the features of a region of interest:
+ *
+ *    NeuroMemSubsample<WIDTH, LEFT, TOP, BW, BH, HB, VB>
+ *      mean grey level of HB x VB blocks of BW x BH pixels, HB*VB components
+ *    NeuroMemRGBHistogram<WIDTH, LEFT, TOP, RW, RH, BITS>
+ *      histograms of the red, green and blue levels, 3 << BITS components
+ *    NeuroMemEdgeHistogram<WIDTH, LEFT, TOP, BW, BH, HB, VB, THRESHOLD>
+ *      per block, the proportion of vertical, horizontal, 45 and 135 degree
+ *      edges, 4*HB*VB components
+ *
+ *  WIDTH is the number of pixels per line, LEFT and TOP the position of the
+ *  region in the frame. The geometry is fixed at compile time: the pixels
+ *  are assigned to their block by counters, without divide, and the sums
+ *  are scaled to [0-255] once per component at the end of the frame.
+ *
+ *    NeuroMemSubsample<320, 96, 56, 8, 8, 16, 16> subsample;
+ *    subsample.begin();
+ *    for (int y=0; y<240; y++)
+ *    {
+ *      SPI.transfer(line, 640);
+ *      subsample.addLine(line);
+ *    }
+ *    subsample.getVector(vector); // 256 components
+ *    hNN.classify(vector, subsample.LENGTH, &dist, &cat, &nid);
+ *
+ *  The grey level is the luminance 0.30 R + 0.59 G + 0.11 B, in [0-255].
+ */
+/******************************************************************************/
+#ifndef _NeuroMemFeatures_h_
+#define _NeuroMemFeatures_h_
+
+extern "C" {
+  #include <stdint.h>
+}
+
+// ------------------------------------------------------------
+// Components of a RGB565 pixel, 2 bytes MSB first
+// ------------------------------------------------------------
+class NeuroMemRGB565
+{
+	public:
+
+		static inline uint8_t red(const uint8_t* pixel) { return(pixel[0] >> 3); } // 5 bits
+		static inline uint8_t green(const uint8_t* pixel) { return(((pixel[0] & 0x07) << 3) | (pixel[1] >> 5)); } // 6 bits
+		static inline uint8_t blue(const uint8_t* pixel) { return(pixel[1] & 0x1F); } // 5 bits
+		static inline uint8_t grey(const uint8_t* pixel)
+		{
+			// components expanded to 8 bits, weights in 1/256
+			uint16_t r=(pixel[0] & 0xF8) | (pixel[0] >> 5);
+			uint16_t g=((pixel[0] & 0x07) << 5) | ((pixel[1] & 0xE0) >> 3) | ((pixel[0] & 0x06) >> 1);
+			uint16_t b=((pixel[1] & 0x1F) << 3) | ((pixel[1] & 0x1F) >> 2);
+			return((uint8_t)((r * 77u + g * 150u + b * 29u) >> 8));
+		}
+};
+
+// ------------------------------------------------------------
+// Sum of up to MAX values of 0-255, on 16 bits when possible
+// ------------------------------------------------------------
+template <bool WIDE> struct NeuroMemSumType { typedef uint16_t type; };
+template <> struct NeuroMemSumType<true> { typedef uint32_t type; };
+template <long MAX> struct NeuroMemSum
+{
+	typedef typename NeuroMemSumType<(MAX * 255 > 0xFFFF)>::type type;
+};
+
+// ------------------------------------------------------------
+// Mean grey level of HB x VB blocks of BW x BH pixels
+// ------------------------------------------------------------
+template <int WIDTH, int LEFT, int TOP, int BW, int BH, int HB, int VB>
+class NeuroMemSubsample
+{
+	public:
+
+		static const int LENGTH=HB * VB;
+		static_assert(LENGTH <= 256, "more components than the memory of a neuron");
+		static_assert(LEFT + HB * BW <= WIDTH, "region wider than the line");
+
+		// start of a frame
+		void begin()
+		{
+			y=0; row=0; rowInBlock=0;
+			for (int i=0; i<LENGTH; i++) sums[i]=0;
+		}
+		// next line of WIDTH pixels
+		void addLine(const uint8_t line[])
+		{
+			if ((y++ < TOP) || (row==VB)) return;
+			Sum* sum=&sums[row * HB];
+			const uint8_t* pixel=line + 2 * LEFT;
+			for (int bx=0; bx<HB; bx++, sum++)
+			{
+				for (int i=0; i<BW; i++, pixel+=2) *sum+=NeuroMemRGB565::grey(pixel);
+			}
+			if (++rowInBlock==BH) { rowInBlock=0; row++; }
+		}
+		void getVector(uint8_t vector[])
+		{
+			for (int i=0; i<LENGTH; i++) vector[i]=(uint8_t)(sums[i] / (BW * BH));
+		}
+		void getVector(int vector[])
+		{
+			for (int i=0; i<LENGTH; i++) vector[i]=(int)(sums[i] / (BW * BH));
+		}
+
+	private:
+
+		typedef typename NeuroMemSum<(long)BW * BH>::type Sum;
+		Sum sums[LENGTH];
+		int y=0, row=0, rowInBlock=0;
+};
+
+// ------------------------------------------------------------
+// Histograms of the red, green and blue levels of a region
+// of RW x RH pixels, 1 << BITS bins per color
+// ------------------------------------------------------------
+template <int WIDTH, int LEFT, int TOP, int RW, int RH, int BITS=3>
+class NeuroMemRGBHistogram
+{
+	public:
+
+		static const int BINS=1 << BITS;
+		static const int LENGTH=3 * BINS;
+		static_assert((BITS >= 1) && (BITS <= 5), "1 to 5 bits per color");
+		static_assert(LEFT + RW <= WIDTH, "region wider than the line");
+
+		void begin()
+		{
+			y=0;
+			for (int i=0; i<LENGTH; i++) counts[i]=0;
+		}
+		void addLine(const uint8_t line[])
+		{
+			if ((y < TOP) || (y >= TOP + RH)) { y++; return; }
+			y++;
+			const uint8_t* pixel=line + 2 * LEFT;
+			for (int x=0; x<RW; x++, pixel+=2)
+			{
+				counts[NeuroMemRGB565::red(pixel) >> (5 - BITS)]++;
+				counts[BINS + (NeuroMemRGB565::green(pixel) >> (6 - BITS))]++;
+				counts[2 * BINS + (NeuroMemRGB565::blue(pixel) >> (5 - BITS))]++;
+			}
+		}
+		// proportion of the pixels in each bin, 255 for all of them
+		void getVector(uint8_t vector[])
+		{
+			for (int i=0; i<LENGTH; i++) vector[i]=(uint8_t)((counts[i] * 255UL) / ((long)RW * RH));
+		}
+		void getVector(int vector[])
+		{
+			for (int i=0; i<LENGTH; i++) vector[i]=(int)((counts[i] * 255UL) / ((long)RW * RH));
+		}
+
+	private:
+
+		typedef typename NeuroMemSum<((long)RW * RH + 254) / 255>::type Count;
+		Count counts[LENGTH];
+		int y=0;
+};
+
+// ------------------------------------------------------------
+// Orientation of the edges in HB x VB blocks of BW x BH pixels.
+// The gradient of a pixel is its difference with the left and
+// upper pixels; pixels with |gx|+|gy| >= THRESHOLD are counted
+// as vertical, horizontal, 45 or 135 degree edges
+// ------------------------------------------------------------
+template <int WIDTH, int LEFT, int TOP, int BW, int BH, int HB, int VB, int THRESHOLD=32>
+class NeuroMemEdgeHistogram
+{
+	public:
+
+		static const int LENGTH=4 * HB * VB;
+		static_assert(LENGTH <= 256, "more components than the memory of a neuron");
+		static_assert(LEFT + HB * BW <= WIDTH, "region wider than the line");
+
+		void begin()
+		{
+			y=0; row=0; rowInBlock=0;
+			for (int i=0; i<LENGTH; i++) counts[i]=0;
+		}
+		void addLine(const uint8_t line[])
+		{
+			if ((y++ < TOP) || (row==VB)) return;
+			const uint8_t* pixel=line + 2 * LEFT;
+			uint8_t* up=previous;
+			int left=NeuroMemRGB565::grey(pixel);
+			bool first=(row==0) && (rowInBlock==0); // no upper line
+			Count* count=&counts[row * HB * 4];
+			for (int bx=0; bx<HB; bx++, count+=4)
+			{
+				for (int i=0; i<BW; i++, pixel+=2, up++)
+				{
+					int grey=NeuroMemRGB565::grey(pixel);
+					int gx=grey - left;
+					int gy=first ? 0 : grey - *up;
+					left=grey;
+					*up=(uint8_t)grey;
+					int ax=gx < 0 ? -gx : gx;
+					int ay=gy < 0 ? -gy : gy;
+					if (ax + ay < THRESHOLD) continue;
+					if (ax > 2 * ay) count[0]++; // vertical edge
+					else if (ay > 2 * ax) count[1]++; // horizontal edge
+					else if ((gx ^ gy) >= 0) count[2]++; // 45 degrees
+					else count[3]++; // 135 degrees
+				}
+			}
+			if (++rowInBlock==BH) { rowInBlock=0; row++; }
+		}
+		// proportion of the pixels of the block, 255 for all of them
+		void getVector(uint8_t vector[])
+		{
+			for (int i=0; i<LENGTH; i++) vector[i]=(uint8_t)((counts[i] * 255UL) / (BW * BH));
+		}
+		void getVector(int vector[])
+		{
+			for (int i=0; i<LENGTH; i++) vector[i]=(int)((counts[i] * 255UL) / (BW * BH));
+		}
+
+	private:
+
+		typedef typename NeuroMemSum<((long)BW * BH + 254) / 255>::type Count;
+		Count counts[LENGTH];
+		uint8_t previous[HB * BW]; // grey levels of the upper line
+		int y=0, row=0, rowInBlock=0;
+};
+#endif
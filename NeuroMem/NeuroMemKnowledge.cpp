@@ -0,0 +1,115 @@
+/************************************************************************/
+/*																		
+ *	NeuroMemKnowledge.cpp	--	Format of the NeuroMem knowledge files (.knf)
+ *	Copyright (c) 2017, General Vision Inc, All rights reserved
+ *
+ */
+/******************************************************************************/
+
+#include <NeuroMemKnowledge.h>
+
+// ------------------------------------------------------------ 
+// Little-endian access independent of the platform
+// ------------------------------------------------------------ 
+void NeuroMemKnowledge::put16(uint8_t* p, uint16_t value)
+{
+	p[0]=(uint8_t)(value & 0xFF);
+	p[1]=(uint8_t)(value >> 8);
+}
+void NeuroMemKnowledge::put32(uint8_t* p, uint32_t value)
+{
+	put16(p, (uint16_t)(value & 0xFFFF));
+	put16(p + 2, (uint16_t)(value >> 16));
+}
+uint16_t NeuroMemKnowledge::get16(const uint8_t* p)
+{
+	return((uint16_t)(p[0] | ((uint16_t)p[1] << 8)));
+}
+uint32_t NeuroMemKnowledge::get32(const uint8_t* p)
+{
+	return((uint32_t)get16(p) | ((uint32_t)get16(p + 2) << 16));
+}
+// ------------------------------------------------------------ 
+// V2 header
+// ------------------------------------------------------------ 
+void NeuroMemKnowledge::packHeader(uint8_t header[], int neuronSize, long ncount, int flags)
+{
+	put16(header, FORMAT_V2);
+	put16(header + 2, (uint16_t)neuronSize);
+	put32(header + 4, (uint32_t)ncount);
+	put16(header + 8, (uint16_t)flags);
+	put16(header + 10, 0);
+	put32(header + 12, 0);
+}
+// ------------------------------------------------------------ 
+// Return the format of the header, 0 if this is not a V2 header
+// ------------------------------------------------------------ 
+int NeuroMemKnowledge::unpackHeader(const uint8_t header[], int* neuronSize, long* ncount, int* flags)
+{
+	if (get16(header)!=FORMAT_V2) return(0);
+	*neuronSize=get16(header + 2);
+	*ncount=(long)get32(header + 4);
+	*flags=get16(header + 8);
+	return(FORMAT_V2);
+}
+// ------------------------------------------------------------ 
+// V2 neuron record
+// ------------------------------------------------------------ 
+int NeuroMemKnowledge::recordHeaderSize(int flags)
+{
+	return((flags & FLAG_USEDLEN) ? REGISTERS_SIZE + 2 : REGISTERS_SIZE);
+}
+int NeuroMemKnowledge::usedLength(const int neuron[], int neuronSize)
+{
+	int length=neuronSize;
+	while ((length > 0) && ((neuron[length] & 0xFF)==0)) length--;
+	return(length);
+}
+int NeuroMemKnowledge::packNeuron(const int neuron[], int neuronSize, int flags, uint8_t record[])
+{
+	put16(record, (uint16_t)neuron[0]);
+	put16(record + 2, (uint16_t)neuron[neuronSize + 1]);
+	put16(record + 4, (uint16_t)neuron[neuronSize + 2]);
+	put16(record + 6, (uint16_t)neuron[neuronSize + 3]);
+	int length=neuronSize;
+	if (flags & FLAG_USEDLEN)
+	{
+		length=usedLength(neuron, neuronSize);
+		put16(record + REGISTERS_SIZE, (uint16_t)length);
+	}
+	uint8_t* comps=record + recordHeaderSize(flags);
+	for (int j=0; j<length; j++) comps[j]=(uint8_t)neuron[j + 1];
+	return(recordHeaderSize(flags) + length);
+}
+int NeuroMemKnowledge::unpackRegisters(const uint8_t record[], int neuronSize, int flags, int neuron[])
+{
+	neuron[0]=get16(record);
+	neuron[neuronSize + 1]=get16(record + 2);
+	neuron[neuronSize + 2]=get16(record + 4);
+	neuron[neuronSize + 3]=get16(record + 6);
+	if (!(flags & FLAG_USEDLEN)) return(neuronSize);
+	int length=get16(record + REGISTERS_SIZE);
+	return(length > neuronSize ? neuronSize : length);
+}
+void NeuroMemKnowledge::unpackComponents(const uint8_t comps[], int length, int neuronSize, int neuron[])
+{
+	for (int j=0; j<length; j++) neuron[j + 1]=comps[j];
+	for (int j=length; j<neuronSize; j++) neuron[j + 1]=0;
+}
+// ------------------------------------------------------------ 
+// Fletcher-32 on bytes, the checksum holds the two running sums
+// so a computation can continue from a saved checksum
+// ------------------------------------------------------------ 
+uint32_t NeuroMemKnowledge::checksum(uint32_t sum, const uint8_t data[], int length)
+{
+	uint32_t sum1=sum & 0xFFFF;
+	uint32_t sum2=sum >> 16;
+	for (int i=0; i<length; i++)
+	{
+		sum1+=data[i];
+		if (sum1 >= 65535) sum1-=65535;
+		sum2+=sum1;
+		if (sum2 >= 65535) sum2-=65535;
+	}
+	return((sum2 << 16) | sum1);
+}
@@ -0,0 +1,65 @@
+/************************************************************************/
+/*																		
+ *	NeuroMemKnowledge.h	--	Format of the NeuroMem knowledge files (.knf)
+ *	Copyright (c) 2017, General Vision Inc, All rights reserved
+ *
+ *  Format V1 (KN_FORMAT 0x1704), written with the int size of the platform
+ *    int header[4]= { 0x1704, NEURONSIZE, ncount, 0 }
+ *    ncount * int neuron[NEURONSIZE+4]= { NCR, NEURONSIZE * COMP, AIF, MINIF, CAT }
+ *
+ *  Format V2 (0x1705), packed little-endian, identical on all platforms
+ *    header, 16 bytes
+ *      uint16 format=0x1705, uint16 neuronSize, uint32 ncount,
+ *      uint16 flags, uint16 reserved, uint32 reserved
+ *    ncount * neuron record
+ *      uint16 NCR, uint16 AIF, uint16 MINIF, uint16 CAT,
+ *      uint16 length (only if flags & FLAG_USEDLEN)
+ *      uint8 COMP[length], or uint8 COMP[neuronSize] without FLAG_USEDLEN
+ *    uint32 checksum, Fletcher-32 of the bytes of the neuron records
+ *  With FLAG_USEDLEN, the components after length are null.
+ *  The checksum does not cover the header, so ncount can be updated in place.
+ */
+/******************************************************************************/
+#ifndef _NeuroMemKnowledge_h_
+#define _NeuroMemKnowledge_h_
+
+extern "C" {
+  #include <stdint.h>
+}
+
+class NeuroMemKnowledge
+{
+	public:
+
+		static const int FORMAT_V1=0x1704;
+		static const int FORMAT_V2=0x1705;
+		static const int HEADER_SIZE=16; // V2 header
+		static const int REGISTERS_SIZE=8; // NCR, AIF, MINIF, CAT of a V2 record
+		static const int CHECKSUM_SIZE=4;
+		static const int FLAG_USEDLEN=0x0001; // per-neuron used length
+
+		static void packHeader(uint8_t header[], int neuronSize, long ncount, int flags);
+		static int unpackHeader(const uint8_t header[], int* neuronSize, long* ncount, int* flags);
+
+		// size of the fixed part of a record, before the components
+		static int recordHeaderSize(int flags);
+		// number of components up to the last non-null one
+		static int usedLength(const int neuron[], int neuronSize);
+		// neuron: NCR, neuronSize * COMP, AIF, MINIF, CAT
+		// return the number of bytes of the record
+		static int packNeuron(const int neuron[], int neuronSize, int flags, uint8_t record[]);
+		// set NCR, AIF, MINIF, CAT of the neuron and return the number of components in the record
+		static int unpackRegisters(const uint8_t record[], int neuronSize, int flags, int neuron[]);
+		// set the components of the neuron, null after length
+		static void unpackComponents(const uint8_t comps[], int length, int neuronSize, int neuron[]);
+
+		// Fletcher-32 checksum, the initial value is 0, and the
+		// checksum of the previous bytes to continue a computation
+		static uint32_t checksum(uint32_t sum, const uint8_t data[], int length);
+
+		static void put16(uint8_t* p, uint16_t value);
+		static void put32(uint8_t* p, uint32_t value);
+		static uint16_t get16(const uint8_t* p);
+		static uint32_t get32(const uint8_t* p);
+};
+#endif
@@ -0,0 +1,171 @@
+/************************************************************************/
+/*
+ *	NeuroMemLogger.cpp	--	Log of the training samples to the SD card
+ *	Copyright (c) 2017, General Vision Inc, All rights reserved
+ *
+ */
+/******************************************************************************/
+
+#include <NeuroMemLogger.h>
+#include <NeuroMemKnowledge.h>
+
+extern "C" {
+  #include <string.h>
+}
+
+NeuroMemLogger::NeuroMemLogger(uint8_t buffer[], int size) : buffer(buffer), size(size)
+{
+}
+// ------------------------------------------------------------
+// Open the log file once, appending to the records of a
+// previous session. The length of each record is read, so a
+// file which ends inside a record is not appended to
+// ------------------------------------------------------------
+int NeuroMemLogger::begin(const char* filename)
+{
+	end();
+	error=false;
+	records=0;
+	writes=0;
+	SDfile = SD.open(filename, FILE_WRITE);
+	if (!SDfile) return(3);
+	uint8_t header[HEADER_SIZE];
+	uint32_t size=SDfile.size();
+	if (size==0)
+	{
+		NeuroMemKnowledge::put16(header, FORMAT);
+		NeuroMemKnowledge::put16(header + 2, 0);
+		NeuroMemKnowledge::put32(header + 4, 0);
+		put(header, HEADER_SIZE);
+		return(0);
+	}
+	SDfile.seek(0);
+	int status=0;
+	if (size < HEADER_SIZE) status=5;
+	else if ((SDfile.read(header, HEADER_SIZE)!=HEADER_SIZE) || (NeuroMemKnowledge::get16(header)!=FORMAT)) status=4;
+	uint32_t position=HEADER_SIZE;
+	while ((status==0) && (position < size))
+	{
+		uint8_t length[4];
+		if ((size - position < 4) || (!SDfile.seek(position)) || (SDfile.read(length, 4)!=4)) status=5;
+		else
+		{
+			uint32_t next=NeuroMemKnowledge::get32(length);
+			if ((next < RECORD_SIZE - 4) || (next > size - position - 4)) status=5;
+			else position+=4 + next;
+		}
+	}
+	if (status!=0) SDfile.close();
+	return(status);
+}
+// ------------------------------------------------------------
+// Copy bytes to the buffer, and write it when it is full
+// ------------------------------------------------------------
+void NeuroMemLogger::put(const uint8_t* data, long length)
+{
+	while (length > 0)
+	{
+		int n=size - used;
+		if (n > length) n=(int)length;
+		memcpy(buffer + used, data, n);
+		used+=n;
+		data+=n;
+		length-=n;
+		if (used==size)
+		{
+			if (SDfile.write(buffer, used)!=(size_t)used) error=true;
+			writes++;
+			used=0;
+		}
+	}
+}
+void NeuroMemLogger::putRecord(uint32_t length, uint8_t kind, int category, int context, unsigned long time)
+{
+	uint8_t record[RECORD_SIZE];
+	NeuroMemKnowledge::put32(record, length);
+	record[4]=kind;
+	record[5]=(uint8_t)context;
+	NeuroMemKnowledge::put16(record + 6, (uint16_t)category);
+	NeuroMemKnowledge::put32(record + 8, (uint32_t)time);
+	put(record, RECORD_SIZE);
+	records++;
+}
+// ------------------------------------------------------------
+// Complete the current frame with black lines, so the records
+// which follow stay readable
+// ------------------------------------------------------------
+void NeuroMemLogger::endFrame()
+{
+	uint8_t black[16];
+	memset(black, 0, sizeof(black));
+	for (; frameLines > 0; frameLines--)
+	{
+		for (int x=0; x<frameWidth * 2; x+=sizeof(black))
+			put(black, frameWidth * 2 - x < (int)sizeof(black) ? frameWidth * 2 - x : sizeof(black));
+	}
+}
+// ------------------------------------------------------------
+// Log a vector, as learned by the neurons
+// ------------------------------------------------------------
+int NeuroMemLogger::logVector(int vector[], int length, int category, int context, unsigned long time)
+{
+	if (!SDfile) return(3);
+	endFrame();
+	putRecord(RECORD_SIZE - 4 + length, VECTOR, category, context, time);
+	uint8_t comps[32];
+	for (int i=0; i<length; i+=sizeof(comps))
+	{
+		int n=length - i < (int)sizeof(comps) ? length - i : sizeof(comps);
+		for (int j=0; j<n; j++) comps[j]=(uint8_t)vector[i + j];
+		put(comps, n);
+	}
+	return(error ? 3 : 0);
+}
+// ------------------------------------------------------------
+// Start a frame of RGB565 pixels, followed by height calls to
+// addLine, for example while the lines are read from the camera
+// ------------------------------------------------------------
+int NeuroMemLogger::beginFrame(int width, int height, int category, int context, unsigned long time)
+{
+	if (!SDfile) return(3);
+	endFrame();
+	putRecord(RECORD_SIZE - 4 + 4 + (uint32_t)width * height * 2, FRAME, category, context, time);
+	uint8_t size[4];
+	NeuroMemKnowledge::put16(size, (uint16_t)width);
+	NeuroMemKnowledge::put16(size + 2, (uint16_t)height);
+	put(size, 4);
+	frameWidth=width;
+	frameLines=height;
+	return(error ? 3 : 0);
+}
+int NeuroMemLogger::addLine(const uint8_t line[])
+{
+	if (!SDfile) return(3);
+	if (frameLines==0) return(0); // the frame is complete
+	put(line, frameWidth * 2);
+	frameLines--;
+	return(error ? 3 : 0);
+}
+// ------------------------------------------------------------
+// Write the buffer and the directory entry of the file
+// ------------------------------------------------------------
+int NeuroMemLogger::flush()
+{
+	if (!SDfile) return(3);
+	if (used > 0)
+	{
+		if (SDfile.write(buffer, used)!=(size_t)used) error=true;
+		writes++;
+		used=0;
+	}
+	SDfile.flush();
+	return(error ? 3 : 0);
+}
+int NeuroMemLogger::end()
+{
+	if (!SDfile) return(0);
+	endFrame();
+	int status=flush();
+	SDfile.close();
+	return(status);
+}
@@ -0,0 +1,89 @@
+/************************************************************************/
+/*
+ *	NeuroMemLogger.h	--	Log of the training samples to the SD card
+ *	Copyright (c) 2017, General Vision Inc, All rights reserved
+ *
+ *  Appends the learned vectors, and optionally their frames, to a log
+ *  file which stays open, through a buffer written to the SD card only
+ *  when it is full:
+ *
+ *    uint8_t buffer[2048];
+ *    NeuroMemLogger logger(buffer, sizeof(buffer));
+ *    logger.begin("samples.nml");
+ *    ...
+ *    logger.logVector(vector, length, category, context, millis());
+ *    logger.beginFrame(320, 240, category, context, millis());
+ *    for (int y=0; y<240; y++) logger.addLine(fifo_burst_line);
+ *    ...
+ *    logger.flush(); // the records are on the card, for example before a power off
+ *
+ *  A buffer of a multiple of 512 bytes writes whole blocks of the card.
+ *  extras/host/log2csv.cpp converts a log file to the CSV format of the
+ *  NeuroMem Knowledge Builder and the frames to PPM images.
+ *
+ *  Log file (.nml), little-endian
+ *    header, 8 bytes
+ *      uint16 format=0x1707, uint16 reserved, uint32 reserved
+ *    records
+ *      uint32 length of the record after this field,
+ *      uint8 kind, uint8 context, uint16 category,
+ *      uint32 time, millis() when the sample was taken,
+ *      VECTOR: uint8 components[length - 8]
+ *      FRAME: uint16 width, uint16 height,
+ *        uint8 pixels[width * height * 2], RGB565 as read from the FIFO
+ *        of the ArduCAM, most significant byte first
+ *  Records are only appended. A power loss without flush usually cuts the
+ *  last record: begin() reads the length of the records of an existing
+ *  file, and returns 5 instead of appending to a cut file, so the next
+ *  session goes to a new file (the example numbers them) and the records
+ *  before the cut stay readable.
+ */
+/******************************************************************************/
+#ifndef _NeuroMemLogger_h_
+#define _NeuroMemLogger_h_
+
+#include <SD.h>
+
+extern "C" {
+  #include <stdint.h>
+}
+
+class NeuroMemLogger
+{
+	public:
+
+		static const int FORMAT=0x1707;
+		static const int HEADER_SIZE=8; // file header
+		static const int RECORD_SIZE=12; // record before its components or frame size
+
+		// kinds of records
+		static const uint8_t VECTOR=1;
+		static const uint8_t FRAME=2;
+
+		NeuroMemLogger(uint8_t buffer[], int size);
+		// Return 0, 3 if the file cannot be opened, 4 if it is not a log file,
+		// 5 if the file ends inside a record, after a power loss
+		int begin(const char* filename);
+		// Return 0, or 3 if the card cannot be written
+		int logVector(int vector[], int length, int category, int context, unsigned long time);
+		int beginFrame(int width, int height, int category, int context, unsigned long time);
+		int addLine(const uint8_t line[]); // width RGB565 pixels, 2 bytes each
+		int flush();
+		int end();
+
+		unsigned long records=0; // records logged since begin
+		unsigned long writes=0; // buffers written to the card
+
+	private:
+		uint8_t* buffer;
+		int size;
+		int used=0; // bytes in the buffer
+		File SDfile;
+		bool error=false;
+		int frameWidth=0;
+		long frameLines=0; // lines still expected for the current frame
+		void put(const uint8_t* data, long length);
+		void putRecord(uint32_t length, uint8_t kind, int category, int context, unsigned long time);
+		void endFrame();
+};
+#endif
@@ -0,0 +1,174 @@
+/************************************************************************/
+/*
+ *	NeuroMemPipeline.cpp	--	Recognition of several features of a frame
+ *
+ */
+/******************************************************************************/
+
+#include <NeuroMemPipeline.h>
+#include <Arduino.h>
+
+NeuroMemPipeline::NeuroMemPipeline(NeuroMemAI &hNN) : hNN(&hNN)
+{
+}
+int NeuroMemPipeline::add(NeuroMemFeature* feature, int context, int minif, int maxif)
+{
+	if (nfeatures==MAX_FEATURES) return(1);
+	feature->context=context;
+	feature->minif=minif;
+	feature->maxif=maxif;
+	features[nfeatures++]=feature;
+	sorted=false;
+	return(0);
+}
+void NeuroMemPipeline::clearTimings()
+{
+	for (int i=0; i<nfeatures; i++)
+	{
+		features[i]->extractMicros=0;
+		features[i]->classifyMicros=0;
+	}
+	contextSwitches=0;
+	switchMicros=0;
+}
+// ------------------------------------------------------------
+// Start of a frame, then each line to all the features
+// ------------------------------------------------------------
+void NeuroMemPipeline::begin()
+{
+	for (int i=0; i<nfeatures; i++) features[i]->begin();
+}
+void NeuroMemPipeline::addLine(const uint8_t line[])
+{
+	for (int i=0; i<nfeatures; i++)
+	{
+		unsigned long start=micros();
+		features[i]->addLine(line);
+		features[i]->extractMicros+=micros() - start;
+	}
+}
+// ------------------------------------------------------------
+// Group the features by context, in the order they were added
+// ------------------------------------------------------------
+void NeuroMemPipeline::sort()
+{
+	for (int i=1; i<nfeatures; i++)
+	{
+		NeuroMemFeature* feature=features[i];
+		int j=i;
+		while ((j > 0) && (features[j-1]->context > feature->context))
+		{
+			features[j]=features[j-1];
+			j--;
+		}
+		features[j]=feature;
+	}
+	sorted=true;
+}
+// ------------------------------------------------------------
+// Index of the first feature of the active context, the
+// broadcasts start there and wrap around
+// ------------------------------------------------------------
+int NeuroMemPipeline::first()
+{
+	if (!sorted) sort();
+	int context, minif, maxif;
+	hNN->getContext(&context, &minif, &maxif);
+	for (int i=0; i<nfeatures; i++)
+	{
+		if (features[i]->context==context) return(i);
+	}
+	return(0);
+}
+void NeuroMemPipeline::select(NeuroMemFeature* feature)
+{
+	int context, minif, maxif;
+	hNN->getContext(&context, &minif, &maxif);
+	if ((context==feature->context) && (minif==feature->minif) && (maxif==feature->maxif)) return;
+	unsigned long start=micros();
+	hNN->setContext(feature->context, feature->minif, feature->maxif);
+	switchMicros+=micros() - start;
+	contextSwitches++;
+}
+// distance per component, x256
+long NeuroMemPipeline::perComponent(NeuroMemFeature* feature)
+{
+	if (feature->length==0) return(0);
+	return(((long)feature->distance << 8) / feature->length);
+}
+// ------------------------------------------------------------
+// Classify the vector of each feature in its context and combine
+// the responses according to the policy
+// ------------------------------------------------------------
+int NeuroMemPipeline::classify(int* distance)
+{
+	int start=first();
+	for (int k=0; k<nfeatures; k++)
+	{
+		NeuroMemFeature* feature=features[(start + k) % nfeatures];
+		select(feature);
+		unsigned long t=micros();
+		feature->length=feature->getVector(vector);
+		hNN->classify(vector, feature->length, &feature->distance, &feature->category, &feature->nid);
+		if (feature->category!=0xFFFF) feature->category&=0x7FFF; // degenerated flag
+		feature->classifyMicros+=micros() - t;
+	}
+
+	int category=0xFFFF;
+	long best=0x7FFFFFFFL;
+	if (policy==UNANIMITY)
+	{
+		// the worst distance of the features
+		best=0;
+		for (int i=0; i<nfeatures; i++)
+		{
+			if ((features[i]->category==0xFFFF) || ((i > 0) && (features[i]->category!=category)))
+			{
+				category=0xFFFF;
+				break;
+			}
+			category=features[i]->category;
+			if (perComponent(features[i]) > best) best=perComponent(features[i]);
+		}
+	}
+	else
+	{
+		int votes=0;
+		for (int i=0; i<nfeatures; i++)
+		{
+			if (features[i]->category==0xFFFF) continue;
+			// votes and best distance of this category
+			int count=0;
+			long closest=0x7FFFFFFFL;
+			for (int j=0; j<nfeatures; j++)
+			{
+				if (features[j]->category!=features[i]->category) continue;
+				count++;
+				if (perComponent(features[j]) < closest) closest=perComponent(features[j]);
+			}
+			if (policy==BEST_DISTANCE) count=1;
+			if ((count > votes) || ((count==votes) && (closest < best)))
+			{
+				votes=count;
+				best=closest;
+				category=features[i]->category;
+			}
+		}
+	}
+	*distance=(category==0xFFFF) ? 0xFFFF : (int)(best > 0x7FFF ? 0x7FFF : best);
+	return(category);
+}
+// ------------------------------------------------------------
+// Learn the vector of each feature in its context
+// ------------------------------------------------------------
+void NeuroMemPipeline::learn(int category)
+{
+	int start=first();
+	for (int k=0; k<nfeatures; k++)
+	{
+		NeuroMemFeature* feature=features[(start + k) % nfeatures];
+		select(feature);
+		feature->length=feature->getVector(vector);
+		hNN->learn(vector, feature->length, category);
+	}
+}
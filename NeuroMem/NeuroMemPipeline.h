@@ -0,0 +1,113 @@
+/************************************************************************/
+/*
+ *	NeuroMemPipeline.h	--	Recognition of several features of a frame
+ *
+ *  NeuroMemPipeline feeds each line of the frame to all its features
+ *  (extractors of NeuroMemFeatures.h wrapped in a NeuroMemFeatureStage),
+ *  so the FIFO is read once. Each feature has its own context, MINIF and
+ *  MAXIF. At the end of the frame, the vectors are broadcast grouped by
+ *  context, starting with the context already active, so the GCR, MINIF
+ *  and MAXIF registers change at most once per context, and the responses
+ *  are combined into one decision:
+ *
+ *    UNANIMITY      all the features recognize the same category
+ *    BEST_DISTANCE  category of the smallest distance per component
+ *    VOTE           category recognized by most features, then by the
+ *                   smallest distance per component
+ *
+ *    NeuroMemFeatureStage<NeuroMemSubsample<320, 96, 56, 8, 8, 16, 16> > subsample;
+ *    NeuroMemFeatureStage<NeuroMemRGBHistogram<320, 96, 56, 128, 128> > histogram;
+ *    NeuroMemPipeline pipeline(hNN);
+ *    pipeline.add(&subsample, 1, 2, 0x4000);
+ *    pipeline.add(&histogram, 2, 2, 0x1000);
+ *
+ *    pipeline.begin();
+ *    for (int y=0; y<240; y++) { SPI.transfer(line, 640); pipeline.addLine(line); }
+ *    cat=pipeline.classify(&dist);
+ *
+ *  The time spent per feature on the lines (extractMicros) and on the
+ *  vector and its classification (classifyMicros) is accumulated until
+ *  clearTimings, and the time spent to change the context in switchMicros.
+ */
+/******************************************************************************/
+#ifndef _NeuroMemPipeline_h_
+#define _NeuroMemPipeline_h_
+
+#include "NeuroMemAI.h"
+#include "NeuroMemFeatures.h"
+
+// ------------------------------------------------------------
+// Feature of a pipeline, and its last response
+// ------------------------------------------------------------
+class NeuroMemFeature
+{
+	public:
+
+		virtual void begin()=0;
+		virtual void addLine(const uint8_t line[])=0;
+		// return the number of components
+		virtual int getVector(int vector[])=0;
+
+		int context=1, minif=2, maxif=0x4000;
+		int distance=0xFFFF, category=0xFFFF, nid=0xFFFF; // of the last classification
+		int length=0; // of the last vector
+		unsigned long extractMicros=0;
+		unsigned long classifyMicros=0;
+};
+
+template <class Extractor>
+class NeuroMemFeatureStage : public NeuroMemFeature
+{
+	public:
+
+		Extractor extractor;
+
+		void begin() { extractor.begin(); }
+		void addLine(const uint8_t line[]) { extractor.addLine(line); }
+		int getVector(int vector[])
+		{
+			extractor.getVector(vector);
+			return(Extractor::LENGTH);
+		}
+};
+
+class NeuroMemPipeline
+{
+	public:
+
+		static const int MAX_FEATURES=8;
+		static const int UNANIMITY=0;
+		static const int BEST_DISTANCE=1;
+		static const int VOTE=2;
+
+		NeuroMemPipeline(NeuroMemAI &hNN);
+		// return 1 if the pipeline has MAX_FEATURES features
+		int add(NeuroMemFeature* feature, int context, int minif, int maxif);
+
+		void begin(); // start of a frame
+		void addLine(const uint8_t line[]);
+		// classify the features of the frame and return the category
+		// of the combined decision, or 0xFFFF, and its distance per component
+		// multiplied by 256
+		int classify(int* distance);
+		// teach the category to each feature, in its context
+		void learn(int category);
+		void clearTimings();
+
+		int policy=BEST_DISTANCE;
+		int nfeatures=0;
+		NeuroMemFeature* features[MAX_FEATURES]; // by context after the first classify or learn
+		int contextSwitches=0; // since clearTimings
+		unsigned long switchMicros=0;
+
+	private:
+
+		NeuroMemAI* hNN;
+		bool sorted=false;
+		int vector[NeuroMemAI::NEURONSIZE];
+		void sort();
+		int first();
+		void select(NeuroMemFeature* feature);
+		long perComponent(NeuroMemFeature* feature);
+};
+#endif
@@ -0,0 +1,128 @@
+/************************************************************************/
+/*
+ *	NeuroMemResultCache.h	--	Responses of the recent vectors of a NeuroMemAI
+ *
+ *  NeuroMemResultCache<LENGTH, ENTRIES> keeps the last ENTRIES vectors
+ *  classified with their response. classify compares the vector to them
+ *  (L1 distance, the sum of the absolute differences of the components) and
+ *  returns the response of the closest one if it is at most threshold away,
+ *  without any SPI traffic. Otherwise the vector is classified by the neurons
+ *  and replaces the least recently used entry:
+ *
+ *    NeuroMemResultCache<256, 2> cache(hNN);
+ *    cache.threshold=512; // 2 levels per component on average
+ *    cache.classify(subsampleFeat, vlen, &dist, &cat, &nid);
+ *
+ *  The entries are not updated on a hit, so a scene which drifts slowly is
+ *  classified again when it is threshold away from the last classified one.
+ *  With the L1 norm, the distance returned on a hit differs from the distance
+ *  of the vector to the same neuron by at most threshold. threshold=0 only
+ *  reuses the responses of identical vectors.
+ *
+ *  The entries are dropped when the generation of the NeuroMemAI changes:
+ *  learn, forget, loadKnowledge_SDcard, writeNeurons, a new context (GCR)
+ *  or a new mode (NSR). Memory: ENTRIES x (LENGTH + 12) bytes.
+ */
+/******************************************************************************/
+#ifndef _NeuroMemResultCache_h_
+#define _NeuroMemResultCache_h_
+
+#include "NeuroMemAI.h"
+
+template <int LENGTH, int ENTRIES=4>
+class NeuroMemResultCache
+{
+	public:
+
+		static_assert((LENGTH > 0) && (LENGTH <= 256), "components of a neuron");
+		static_assert(ENTRIES > 0, "at least one entry");
+
+		long threshold=0; // largest L1 distance to reuse a response
+		unsigned long hits=0, misses=0;
+
+		NeuroMemResultCache(NeuroMemAI &hNN) : hNN(&hNN) { clear(); }
+
+		// return the status of the network: 0= unknown, 4=uncertain, 8=Identified
+		int classify(int vector[], int length, int* distance, int* category, int* nid)
+		{
+			if (hNN->generation!=generation) clear();
+			Entry* entry=lookup(vector, length);
+			if (entry!=0)
+			{
+				hits++;
+				entry->used=++clock;
+				*distance=entry->distance; *category=entry->category; *nid=entry->nid;
+				return(entry->nsr);
+			}
+			misses++;
+			int nsr=hNN->classify(vector, length, distance, category, nid);
+			if (length > LENGTH) return(nsr);
+			// the least recently used entry
+			entry=&entries[0];
+			for (int i=1; i<ENTRIES; i++)
+			{
+				if (entries[i].used < entry->used) entry=&entries[i];
+			}
+			for (int i=0; i<length; i++) entry->vector[i]=(uint8_t)vector[i];
+			entry->length=length;
+			entry->nsr=nsr; entry->distance=*distance; entry->category=*category; entry->nid=*nid;
+			entry->used=++clock;
+			return(nsr);
+		}
+		// drop the entries
+		void clear()
+		{
+			for (int i=0; i<ENTRIES; i++)
+			{
+				entries[i].length=0;
+				entries[i].used=0;
+			}
+			generation=hNN->generation;
+		}
+		void clearCounters()
+		{
+			hits=0;
+			misses=0;
+		}
+
+	private:
+
+		struct Entry
+		{
+			uint8_t vector[LENGTH];
+			int length; // 0 if empty
+			int nsr, distance, category, nid;
+			unsigned long used;
+		};
+		NeuroMemAI* hNN;
+		Entry entries[ENTRIES];
+		unsigned long generation=0;
+		unsigned long clock=0;
+
+		// closest entry at most threshold away, the sums stop
+		// as soon as they exceed the best one
+		Entry* lookup(int vector[], int length)
+		{
+			Entry* best=0;
+			long limit=threshold;
+			for (int e=0; e<ENTRIES; e++)
+			{
+				Entry* entry=&entries[e];
+				if ((entry->length==0) || (entry->length!=length)) continue;
+				long delta=0;
+				for (int i=0; (i<length) && (delta <= limit); i++)
+				{
+					int d=(vector[i] & 0xFF) - entry->vector[i];
+					delta+=d < 0 ? -d : d;
+				}
+				if (delta <= limit)
+				{
+					best=entry;
+					limit=delta - 1;
+					if (delta==0) break;
+				}
+			}
+			return(best);
+		}
+};
+#endif
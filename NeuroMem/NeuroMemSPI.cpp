@@ -23,6 +23,7 @@
 using namespace std;
 extern "C" {
   #include <stdint.h>
+  #include <string.h>
 }
 
 #define HW_BRAINCARD 1 // neuron access through SPI_CS pin 10
@@ -39,10 +40,15 @@ extern "C" {
 #define CK_NEUROSHIELD 2000000 // 2 Mhz
 #define CK_NEUROTILE 4000000 // 4Mhz
 
-int SPISelectPin;
-int SPIspeed;
+static const int FPGAFlashPin = 8;
 
-int FPGAFlashPin = 8;
+#ifdef NM_SPI_STATS
+#define NM_STATS_START unsigned long statsStart=micros();
+#define NM_STATS_RECORD(mod, reg, bytes) record(mod, reg, bytes, statsStart);
+#else
+#define NM_STATS_START
+#define NM_STATS_RECORD(mod, reg, bytes)
+#endif
 // ------------------------------------------------------------ //
 //    Constructor to the class BraincardNeurons
 // ------------------------------------------------------------ 
@@ -56,6 +62,70 @@ NeuroMemSPI::NeuroMemSPI(){
 int NeuroMemSPI::connect(int Platform)
 {
 	SPI.begin();
+	configure(Platform);
+	reset();
+	// If NM chip present and SPI comm successful
+	// Read MINIF (reg 6) and verify that it is equal to 
+	if(read(mod_NM, 6)==2)return(0);else return(1); 
+}
+// ------------------------------------------------------------ 
+// Connect to a NeuroMem device of a platform wired on another
+// chip select, or clocked at another speed, for example when
+// several devices share the SPI bus
+// ------------------------------------------------------------ 
+int NeuroMemSPI::connect(int Platform, int pin, long clock)
+{
+	SPI.begin();
+	configure(Platform);
+	selectPin=pin;
+	speed=clock;
+	pinMode (selectPin, OUTPUT);
+	digitalWrite(selectPin, HIGH);
+	reset();
+	if(read(mod_NM, 6)==2)return(0);else return(1); 
+}
+// ------------------------------------------------------------ 
+// Detect the platform and connect to it, return the platform
+// or 0 if no NeuroMem network answers
+// The chip selects are probed first without the reset of connect,
+// and its delays, since the network is ready after a power-up:
+// the NeuroShield, then the BrainCard and NeuroTile which share
+// the chip select 10 and differ by the FPGA revision register,
+// null on the NeuroTile. A network which does not answer, for
+// example left in Save and Restore mode, is then reset
+// The probes send NeuroMem transactions on the chip selects 7 and 10,
+// and drive the pins 5 and 6 of the NeuroShield and the FPGA Flash
+// pin 8 of the BrainCard, whatever is wired to them: with another
+// device on one of these pins, call connect with the platform instead
+// ------------------------------------------------------------ 
+int NeuroMemSPI::detect()
+{
+	SPI.begin();
+	static const int platforms[3]={ HW_NEUROSHIELD, HW_BRAINCARD, HW_NEUROTILE };
+	bool found=false;
+	for (int i=0; (i<2) && (!found); i++)
+	{
+		configure(platforms[i]);
+		found=(read(mod_NM, 6)==2);
+	}
+	for (int i=0; (i<3) && (!found); i++) found=(connect(platforms[i])==0);
+	if (!found)
+	{
+		platform=0;
+		return(0);
+	}
+	if (platform!=HW_NEUROSHIELD)
+	{
+		int rev=read(mod_NM, 0x0E);
+		configure(((rev==0) || (rev==0xFFFF)) ? HW_NEUROTILE : HW_BRAINCARD);
+	}
+	return(platform);
+}
+// ------------------------------------------------------------ 
+// Set the pins and the SPI clock of a platform
+// ------------------------------------------------------------ 
+void NeuroMemSPI::configure(int Platform)
+{
 	platform=Platform;
 	switch(platform)
 	{
@@ -64,43 +134,46 @@ int NeuroMemSPI::connect(int Platform)
 			digitalWrite(5, LOW); // pin Arduino_CON
 			pinMode (6, OUTPUT); //pin Arduino_SD_CS
 			digitalWrite(6,HIGH); // pin Arduino_SD_CS
-			SPISelectPin = NM_CS_NEUROSHIELD;
-			SPIspeed= CK_NEUROSHIELD;
-			pinMode (SPISelectPin, OUTPUT);
-			digitalWrite(SPISelectPin, HIGH);
+			selectPin = NM_CS_NEUROSHIELD;
+			speed= CK_NEUROSHIELD;
 			break;
 		case HW_BRAINCARD:
-			SPISelectPin = NM_CS_BRAINCARD;
-			SPIspeed= CK_BRAINCARD;
-			// SPISelectPin and FPGAFlashPin must toggle together
-			FPGAFlashPin=8;
-			pinMode (SPISelectPin, OUTPUT);
+			selectPin = NM_CS_BRAINCARD;
+			speed= CK_BRAINCARD;
 			pinMode (FPGAFlashPin, OUTPUT);	// Using FPGA Flash pin
-			digitalWrite(SPISelectPin, HIGH);
 			digitalWrite(FPGAFlashPin, HIGH);
-			// Reset by pulling both CSn low and returning to high
-			digitalWrite(SPISelectPin, LOW);
+			break;
+		case HW_NEUROTILE: 
+			selectPin = NM_CS_NEUROTILE;
+			speed= CK_NEUROTILE;
+			break;
+	} 
+	pinMode (selectPin, OUTPUT);
+	digitalWrite(selectPin, HIGH);
+}
+// ------------------------------------------------------------ 
+// Reset the BrainCard and NeuroTile by pulling their chip select low
+// ------------------------------------------------------------ 
+void NeuroMemSPI::reset()
+{
+	switch(platform)
+	{
+		case HW_BRAINCARD:
+			// selectPin and FPGAFlashPin must toggle together
+			digitalWrite(selectPin, LOW);
 			digitalWrite(FPGAFlashPin, LOW);
 			delay(200);
-			digitalWrite(SPISelectPin, HIGH);
+			digitalWrite(selectPin, HIGH);
 			digitalWrite(FPGAFlashPin, HIGH);
 			delay(500);
 			break;
 		case HW_NEUROTILE: 
-			SPISelectPin = NM_CS_NEUROTILE;
-			SPIspeed= CK_NEUROTILE;
-			pinMode (SPISelectPin, OUTPUT);
-			digitalWrite(SPISelectPin, HIGH);
-			// Reset by pulling both CSn low and returning to high
-			digitalWrite(SPISelectPin, LOW);
+			digitalWrite(selectPin, LOW);
 			delay(200);
-			digitalWrite(SPISelectPin, HIGH);
+			digitalWrite(selectPin, HIGH);
 			delay(500);
 			break;
 	} 
-	// If NM chip present and SPI comm successful
-	// Read MINIF (reg 6) and verify that it is equal to 
-	if(read(mod_NM, 6)==2)return(0);else return(1); 
 }
 // --------------------------------------------------------
 // Read the FPGA_version
@@ -121,8 +194,10 @@ int NeuroMemSPI::FPGArev()
 //---------------------------------------------------------
 int NeuroMemSPI::read(unsigned char mod, unsigned char reg)
 {
-	SPI.beginTransaction(SPISettings(SPIspeed, MSBFIRST, SPI_MODE0));
-	digitalWrite(SPISelectPin, LOW);
+	NM_STATS_START
+	unsigned long traceStart=(trace!=0) ? micros() : 0;
+	SPI.beginTransaction(SPISettings(speed, MSBFIRST, SPI_MODE0));
+	digitalWrite(selectPin, LOW);
 	SPI.transfer(1);  // Dummy for ID
 	SPI.transfer(mod);
 	SPI.transfer(0);
@@ -133,8 +208,10 @@ int NeuroMemSPI::read(unsigned char mod, unsigned char reg)
 	SPI.transfer(1); // length [7-0]
 	int data = SPI.transfer(0); // Send 0 to push upper data out
 	data = (data << 8) + SPI.transfer(0); // Send 0 to push lower data out
-	digitalWrite(SPISelectPin, HIGH);
+	digitalWrite(selectPin, HIGH);
 	SPI.endTransaction();
+	NM_STATS_RECORD(mod, reg, 10)
+	if (trace!=0) trace->record(NeuroMemTrace::READ, mod, reg, traceStart, 1, &data);
 	return(data);
 }
 // ---------------------------------------------------------
@@ -142,8 +219,10 @@ int NeuroMemSPI::read(unsigned char mod, unsigned char reg)
 // ---------------------------------------------------------
 void NeuroMemSPI::write(unsigned char mod, unsigned char reg, int data)
 {
-	SPI.beginTransaction(SPISettings(SPIspeed, MSBFIRST, SPI_MODE0));
-	digitalWrite(SPISelectPin, LOW);
+	NM_STATS_START
+	unsigned long traceStart=(trace!=0) ? micros() : 0;
+	SPI.beginTransaction(SPISettings(speed, MSBFIRST, SPI_MODE0));
+	digitalWrite(selectPin, LOW);
 	SPI.transfer(1);  // Dummy for ID
 	SPI.transfer(mod + 0x80); // module and write flag
 	SPI.transfer(0);
@@ -154,33 +233,41 @@ void NeuroMemSPI::write(unsigned char mod, unsigned char reg, int data)
 	SPI.transfer(1); // length[7-0]
 	SPI.transfer((unsigned char)(data >> 8)); // upper data
 	SPI.transfer((unsigned char)(data & 0x00FF)); // lower data
-	digitalWrite(SPISelectPin, HIGH);
+	digitalWrite(selectPin, HIGH);
 	SPI.endTransaction();
+	NM_STATS_RECORD(mod, reg, 10)
+	if (trace!=0) trace->record(NeuroMemTrace::WRITE, mod, reg, traceStart, 1, &data);
 }
 // ---------------------------------------------------------
 // SPI Write_Addr command
 // multiple write of data in word format
 // length is expressed in words
+// The address is not incremented, so all the words are written
+// to the same register (ex: a stream of components to COMP)
 // ---------------------------------------------------------
 void NeuroMemSPI::writeAddr(long addr, int length, int data[])
 {
-	SPI.beginTransaction(SPISettings(SPIspeed, MSBFIRST, SPI_MODE0));
-	digitalWrite(SPISelectPin, LOW);
+	NM_STATS_START
+	unsigned long traceStart=(trace!=0) ? micros() : 0;
+	SPI.beginTransaction(SPISettings(speed, MSBFIRST, SPI_MODE0));
+	digitalWrite(selectPin, LOW);
 	SPI.transfer(1);  // Dummy for ID
 	SPI.transfer((byte)(((addr & 0xFF000000) >> 24) + 0x80)); // Addr3 and write flag
 	SPI.transfer((byte)((addr & 0x00FF0000) >> 16)); // Addr2
 	SPI.transfer((byte)((addr & 0x0000FF00) >> 8)); // Addr1
 	SPI.transfer((byte)(addr & 0x000000FF)); // Addr0
 	SPI.transfer((byte)((length & 0x00FF0000) >> 16)); // Length2
-	SPI.transfer((byte)(length & 0x0000FF00) >> 8); // Length1
+	SPI.transfer((byte)((length & 0x0000FF00) >> 8)); // Length1
 	SPI.transfer((byte)(length & 0x000000FF)); // Length 0
 	for (int i = 0; i < length; i++)
 	{
 		SPI.transfer((data[i] & 0xFF00)>> 8);
 		SPI.transfer(data[i] & 0x00FF);
 	}
-	digitalWrite(SPISelectPin, HIGH);
+	digitalWrite(selectPin, HIGH);
 	SPI.endTransaction();
+	NM_STATS_RECORD((addr >> 24) & 0x7F, addr & 0xFF, 8 + 2 * length)
+	if (trace!=0) trace->record(NeuroMemTrace::WRITE_ADDR, (addr >> 24) & 0x7F, addr & 0xFF, traceStart, length, data);
 } 
 //---------------------------------------------
 // SPI Read_Addr command
@@ -189,22 +276,64 @@ void NeuroMemSPI::writeAddr(long addr, int length, int data[])
 //---------------------------------------------
 void NeuroMemSPI::readAddr(long addr, int length, int data[])
 {
-	SPI.beginTransaction(SPISettings(SPIspeed, MSBFIRST, SPI_MODE0));
-	digitalWrite(SPISelectPin, LOW);
+	NM_STATS_START
+	unsigned long traceStart=(trace!=0) ? micros() : 0;
+	SPI.beginTransaction(SPISettings(speed, MSBFIRST, SPI_MODE0));
+	digitalWrite(selectPin, LOW);
 	SPI.transfer(1);  // Dummy for ID
 	SPI.transfer((byte)((addr & 0xFF000000) >> 24)); // Addr3 and write flag
 	SPI.transfer((byte)((addr & 0x00FF0000) >> 16)); // Addr2
 	SPI.transfer((byte)((addr & 0x0000FF00) >> 8)); // Addr1
 	SPI.transfer((byte)(addr & 0x000000FF)); // Addr0
 	SPI.transfer((byte)((length & 0x00FF0000) >> 16)); // Length2
-	SPI.transfer((byte)(length & 0x0000FF00) >> 8); // Length1
+	SPI.transfer((byte)((length & 0x0000FF00) >> 8)); // Length1
 	SPI.transfer((byte)(length & 0x000000FF)); // Lenght0
 	for (int i = 0; i < length; i++)
 	{
 		data[i] = SPI.transfer(0); // Send 0 to push upper data out
 		data[i] = (data[i] << 8) + SPI.transfer(0); // Send 0 to push lower data out
 	}
-	digitalWrite(SPISelectPin, HIGH);
+	digitalWrite(selectPin, HIGH);
 	SPI.endTransaction();
+	NM_STATS_RECORD((addr >> 24) & 0x7F, addr & 0xFF, 8 + 2 * length)
+	if (trace!=0) trace->record(NeuroMemTrace::READ_ADDR, (addr >> 24) & 0x7F, addr & 0xFF, traceStart, length, data);
+}
+// ---------------------------------------------------------
+// Mark the start of a function of NeuroMemAI in the trace
+// ---------------------------------------------------------
+void NeuroMemSPI::mark(const char* operation)
+{
+	if (trace!=0) trace->mark(operation, micros());
 }
 
+// ---------------------------------------------------------
+// Statistics of the SPI transactions, counted only when the
+// library is compiled with NM_SPI_STATS
+// ---------------------------------------------------------
+void NeuroMemSPI::resetStats()
+{
+	if (stats==0) return;
+	memset(stats, 0, sizeof(NeuroMemSPIStats));
+	stats->minMicros=0xFFFFFFFF;
+}
+// Copy the statistics, for example of a frame, and optionally reset them
+void NeuroMemSPI::snapshotStats(NeuroMemSPIStats* frame, bool reset)
+{
+	if (stats==0) return;
+	*frame=*stats;
+	if (reset) resetStats();
+}
+void NeuroMemSPI::record(unsigned char mod, unsigned char reg, int bytes, unsigned long start)
+{
+	if (stats==0) return;
+	unsigned long elapsed=micros() - start;
+	int i=((mod==mod_NM) && (reg < NeuroMemSPIStats::OTHER)) ? reg : NeuroMemSPIStats::OTHER;
+	stats->count[i]++;
+	stats->bytes[i]+=bytes;
+	stats->micros[i]+=elapsed;
+	if (elapsed < stats->minMicros) stats->minMicros=elapsed;
+	if (elapsed > stats->maxMicros) stats->maxMicros=elapsed;
+	int bin=0;
+	while ((bin < NeuroMemSPIStats::BINS - 1) && (elapsed >> (bin + 1))) bin++;
+	stats->histogram[bin]++;
+}
@@ -9,25 +9,60 @@
 #define _NeuroMemSPI_h_
 
 #include "SPI.h"
+#include "NeuroMemTransport.h"
+#include "NeuroMemTrace.h"
 
 extern "C" {
   #include <stdint.h>
 }
 
-class NeuroMemSPI
+// Uncomment, or define on the compiler command line, to measure the SPI
+// transactions in NeuroMemSPI::stats. Without it, the measure has no cost.
+// The define does not change the layout of the classes
+//#define NM_SPI_STATS
+
+// SPI transactions since the last resetStats
+// The registers 0 to 15 of the NeuroMem module are counted separately,
+// the other modules and registers together in the entry OTHER
+struct NeuroMemSPIStats
+{
+	static const int OTHER=16;
+	static const int BINS=12; // bin i counts the calls of 2^i to 2^(i+1)-1 us, bin 0 below 2 us
+	unsigned long count[OTHER + 1]; // transactions
+	unsigned long bytes[OTHER + 1]; // bytes on the bus
+	unsigned long micros[OTHER + 1]; // elapsed time
+	unsigned long minMicros; // latency of the fastest and slowest calls
+	unsigned long maxMicros;
+	unsigned long histogram[BINS]; // latency of the calls
+};
+
+class NeuroMemSPI : public NeuroMemTransport
 {
 	public:
 			
 		static const int mod_NM=0x01; // Addr[24:31] to access a NeuroMem chip
 			
 		NeuroMemSPI();
-		int platform=0;		
+		int platform=0;
+		int selectPin=0; // chip select of the NeuroMem device, set by connect
+		long speed=0; // SPI clock, set by connect
 		int connect(int Platform);		
+		int connect(int Platform, int pin, long clock);
+		int detect();
 		int FPGArev();			
 		int read(unsigned char mod, unsigned char reg);
 		void write(unsigned char mod, unsigned char reg, int data);
 		void writeAddr(long addr, int length, int data[]);
 		void readAddr(long addr, int length, int data[]);						
-		
+		void mark(const char* operation);
+		NeuroMemTrace* trace=0; // records the transactions if not null
+		NeuroMemSPIStats* stats=0; // counts the transactions if not null, with NM_SPI_STATS
+		void resetStats();
+		void snapshotStats(NeuroMemSPIStats* frame, bool reset=true);
+
+	private:
+		void configure(int Platform);
+		void reset();
+		void record(unsigned char mod, unsigned char reg, int bytes, unsigned long start);
 };
 #endif
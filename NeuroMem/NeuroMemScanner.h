@@ -0,0 +1,179 @@
+/************************************************************************/
+/*
+ *	NeuroMemScanner.h	--	Classification of windows anywhere in a frame
+ *
+ *  NeuroMemScanner<WIDTH, HEIGHT, CELL, GRID> consumes the lines of a RGB565
+ *  frame (2 bytes per pixel, MSB first) as they are read from the FIFO of the
+ *  ArduCAM, sums the grey levels of cells of CELL x CELL pixels, and builds
+ *  the integral table of the cells as each row of cells is complete.
+ *  After the last line, the subsample vector of any square window aligned
+ *  on the cells takes GRID x GRID lookups of 4 table entries, whatever the
+ *  size of the window:
+ *
+ *    NeuroMemScanner<320, 240, 8, 8> scanner; // 40x30 cells, 64 components
+ *    scanner.begin();
+ *    for (int y=0; y<240; y++)
+ *    {
+ *      SPI.transfer(line, 640);
+ *      scanner.addLine(line);
+ *    }
+ *    NeuroMemWindowScale scales[2]={ { 16, 4 }, { 24, 6 } }; // size and step, in cells
+ *    int n=scanner.scan(hNN, scales, 2, hits, 16);
+ *
+ *  scan classifies the windows of each scale from the top left of the
+ *  frame, and returns the windows recognized by the neurons: position and
+ *  size in pixels, category, distance and identifier of the top firing neuron.
+ *  The vector of the next window is computed during the transfer of the
+ *  current one when the transport of NeuroMemAI is asynchronous, see
+ *  NeuroMemAI::beginClassify. The neurons learn a window with
+ *  getVector and NeuroMemAI::learn, on the same cells and grid.
+ *
+ *  Memory: (WIDTH/CELL+1) x (HEIGHT/CELL+1) 32-bit entries, 5 KB for the
+ *  cells of 8x8 pixels of a 320x240 frame, 1.3 KB for cells of 16x16 pixels.
+ */
+/******************************************************************************/
+#ifndef _NeuroMemScanner_h_
+#define _NeuroMemScanner_h_
+
+#include "NeuroMemAI.h"
+#include "NeuroMemFeatures.h"
+
+struct NeuroMemWindowScale
+{
+	int size; // side of the windows, in cells, at least GRID
+	int step; // distance between the windows, in cells
+};
+
+struct NeuroMemWindowHit
+{
+	int x, y, size; // window, in pixels
+	int category; // with the degenerated flag in bit 15
+	int distance;
+	int nid;
+};
+
+template <int WIDTH, int HEIGHT, int CELL, int GRID>
+class NeuroMemScanner
+{
+	public:
+
+		static const int CW=WIDTH / CELL; // cells per row
+		static const int CH=HEIGHT / CELL; // rows of cells
+		static const int LENGTH=GRID * GRID;
+		static_assert(LENGTH <= 256, "more components than the memory of a neuron");
+		static_assert((GRID <= CW) && (GRID <= CH), "grid larger than the frame");
+
+		// start of a frame
+		void begin()
+		{
+			y=0; row=0; rowInCell=0;
+			for (int c=0; c<CW; c++) cells[c]=0;
+			for (int c=0; c<=CW; c++) integral[c]=0;
+		}
+		// next line of WIDTH pixels
+		void addLine(const uint8_t line[])
+		{
+			if ((y++ >= HEIGHT) || (row==CH)) return;
+			const uint8_t* pixel=line;
+			for (int c=0; c<CW; c++)
+			{
+				for (int i=0; i<CELL; i++, pixel+=2) cells[c]+=NeuroMemRGB565::grey(pixel);
+			}
+			if (++rowInCell < CELL) return;
+			// integral of the new row of cells
+			uint32_t* above=&integral[row * (CW + 1)];
+			uint32_t* entry=above + CW + 1;
+			uint32_t sum=0;
+			entry[0]=0;
+			for (int c=0; c<CW; c++)
+			{
+				sum+=cells[c];
+				entry[c + 1]=above[c + 1] + sum;
+				cells[c]=0;
+			}
+			rowInCell=0;
+			row++;
+		}
+		// true when the integral table covers all the cells
+		bool complete()
+		{
+			return(row==CH);
+		}
+		// subsample vector of the window of size x size cells at the cell (cx, cy),
+		// mean grey level of GRID x GRID blocks of whole cells.
+		// Return 1 if the window is not inside the frame
+		int getVector(int cx, int cy, int size, int vector[])
+		{
+			if ((cx < 0) || (cy < 0) || (size < GRID) || (cx + size > CW) || (cy + size > row)) return(1);
+			for (int by=0; by<GRID; by++)
+			{
+				int y0=cy + (by * size) / GRID, y1=cy + ((by + 1) * size) / GRID;
+				for (int bx=0; bx<GRID; bx++)
+				{
+					int x0=cx + (bx * size) / GRID, x1=cx + ((bx + 1) * size) / GRID;
+					uint32_t sum=at(x1, y1) - at(x0, y1) - at(x1, y0) + at(x0, y0);
+					*vector++=(int)(sum / ((uint32_t)(x1 - x0) * (y1 - y0) * CELL * CELL));
+				}
+			}
+			return(0);
+		}
+		// classify the windows of the scales and return the number of windows
+		// recognized, up to maxHits, in hits; windows counts the windows classified
+		int scan(NeuroMemAI &hNN, const NeuroMemWindowScale scales[], int nscales,
+			NeuroMemWindowHit hits[], int maxHits)
+		{
+			int vectors[2][LENGTH];
+			int x[2], y[2], size[2];
+			int nhits=0, current=0;
+			bool pending=false;
+			windows=0;
+			for (int s=0; s<nscales; s++)
+			{
+				int step=scales[s].step > 0 ? scales[s].step : 1;
+				for (int cy=0; cy + scales[s].size <= CH; cy+=step)
+				{
+					for (int cx=0; cx + scales[s].size <= CW; cx+=step)
+					{
+						int next=pending ? 1 - current : current;
+						if (getVector(cx, cy, scales[s].size, vectors[next])!=0) continue;
+						x[next]=cx; y[next]=cy; size[next]=scales[s].size;
+						if (pending) nhits=finish(hNN, x[current], y[current], size[current], hits, nhits, maxHits);
+						hNN.beginClassify(vectors[next], LENGTH);
+						current=next;
+						pending=true;
+						windows++;
+					}
+				}
+			}
+			if (pending) nhits=finish(hNN, x[current], y[current], size[current], hits, nhits, maxHits);
+			return(nhits);
+		}
+
+		int windows=0; // windows classified by the last scan
+
+	private:
+
+		typedef typename NeuroMemSum<(long)CELL * CELL>::type CellSum;
+		CellSum cells[CW]; // sums of the current row of cells
+		uint32_t integral[(CW + 1) * (CH + 1)]; // sums of the cells above and left of each entry
+		int y=0, row=0, rowInCell=0;
+
+		inline uint32_t at(int cx, int cy)
+		{
+			return(integral[cy * (CW + 1) + cx]);
+		}
+		int finish(NeuroMemAI &hNN, int cx, int cy, int size, NeuroMemWindowHit hits[], int nhits, int maxHits)
+		{
+			int distance, category, nid;
+			hNN.finishClassify(&distance, &category, &nid);
+			if ((category==0xFFFF) || (nhits==maxHits)) return(nhits);
+			hits[nhits].x=cx * CELL;
+			hits[nhits].y=cy * CELL;
+			hits[nhits].size=size * CELL;
+			hits[nhits].category=category;
+			hits[nhits].distance=distance;
+			hits[nhits].nid=nid;
+			return(nhits + 1);
+		}
+};
+#endif
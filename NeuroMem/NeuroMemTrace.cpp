@@ -0,0 +1,117 @@
+/************************************************************************/
+/*																		
+ *	NeuroMemTrace.cpp	--	Trace of the SPI transactions of a NeuroMem network
+ *	Copyright (c) 2017, General Vision Inc, All rights reserved
+ *
+ */
+/******************************************************************************/
+
+#include <NeuroMemTrace.h>
+#include <NeuroMemKnowledge.h>
+#include <SD.h>
+
+extern "C" {
+  #include <string.h>
+}
+
+NeuroMemTrace::NeuroMemTrace(uint8_t buffer[], long size) : buffer(buffer), size(size)
+{
+}
+void NeuroMemTrace::clear()
+{
+	used=0;
+	dropped=0;
+	first=0;
+	next=0;
+}
+// ------------------------------------------------------------ 
+// Byte access to the ring buffer
+// ------------------------------------------------------------ 
+void NeuroMemTrace::put(uint8_t value)
+{
+	buffer[next]=value;
+	if (++next==size) next=0;
+}
+uint8_t NeuroMemTrace::get(long offset)
+{
+	return(buffer[(first + offset) % size]);
+}
+// ------------------------------------------------------------ 
+// Drop the oldest records until bytes are free, return false
+// if the record cannot fit in the buffer
+// ------------------------------------------------------------ 
+bool NeuroMemTrace::reserve(long bytes)
+{
+	if (bytes > size)
+	{
+		dropped++;
+		return(false);
+	}
+	while (size - used < bytes)
+	{
+		long length=get(3) | ((long)get(4) << 8);
+		long record=RECORD_SIZE + ((get(0)==MARK) ? length : 2 * length);
+		first=(first + record) % size;
+		used-=record;
+		dropped++;
+	}
+	used+=bytes;
+	return(true);
+}
+// ------------------------------------------------------------ 
+// Record a transaction and the words read or written
+// ------------------------------------------------------------ 
+void NeuroMemTrace::record(uint8_t kind, uint8_t mod, uint8_t reg, unsigned long time, int length, const int data[])
+{
+	if (!reserve(RECORD_SIZE + 2L * length)) return;
+	put(kind);
+	put(mod);
+	put(reg);
+	put((uint8_t)(length & 0xFF));
+	put((uint8_t)(length >> 8));
+	for (int i=0; i<4; i++) put((uint8_t)(time >> (8 * i)));
+	for (int i=0; i<length; i++)
+	{
+		put((uint8_t)(data[i] & 0xFF));
+		put((uint8_t)((data[i] >> 8) & 0xFF));
+	}
+}
+// ------------------------------------------------------------ 
+// Mark the start of a function of NeuroMemAI
+// ------------------------------------------------------------ 
+void NeuroMemTrace::mark(const char* name, unsigned long time)
+{
+	int length=strlen(name);
+	if (!reserve(RECORD_SIZE + length)) return;
+	put(MARK);
+	put(0);
+	put(0);
+	put((uint8_t)(length & 0xFF));
+	put((uint8_t)(length >> 8));
+	for (int i=0; i<4; i++) put((uint8_t)(time >> (8 * i)));
+	for (int i=0; i<length; i++) put((uint8_t)name[i]);
+}
+// ------------------------------------------------------------ 
+// Save the records to a trace file, oldest first
+// ------------------------------------------------------------ 
+int NeuroMemTrace::save_SDcard(char* filename)
+{
+	if (SD.exists(filename)) SD.remove(filename);
+	File SDfile = SD.open(filename, FILE_WRITE);
+	if (!SDfile) return(3);
+	uint8_t header[HEADER_SIZE];
+	NeuroMemKnowledge::put16(header, FORMAT);
+	NeuroMemKnowledge::put16(header + 2, 0);
+	NeuroMemKnowledge::put32(header + 4, dropped);
+	SDfile.write(header, HEADER_SIZE);
+	// the records wrap at the end of the buffer
+	long tail=size - first;
+	if (tail >= used) SDfile.write(buffer + first, used);
+	else
+	{
+		SDfile.write(buffer + first, tail);
+		SDfile.write(buffer, used - tail);
+	}
+	SDfile.close();
+	return(0);
+}
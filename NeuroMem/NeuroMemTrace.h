@@ -0,0 +1,70 @@
+/************************************************************************/
+/*																		
+ *	NeuroMemTrace.h	--	Trace of the SPI transactions of a NeuroMem network
+ *	Copyright (c) 2017, General Vision Inc, All rights reserved
+ *
+ *  NeuroMemSPI records its transactions in a NeuroMemTrace when spi.trace
+ *  points to one, and NeuroMemAI marks the start of its functions:
+ *
+ *    uint8_t buffer[4096];
+ *    NeuroMemTrace trace(buffer, sizeof(buffer));
+ *    hNN.spi.trace=&trace;
+ *    ...
+ *    trace.save_SDcard("session.nmt");
+ *
+ *  The records are kept in a ring buffer: when it is full, the oldest
+ *  records are dropped. extras/host/replay_trace.cpp replays a trace file
+ *  on the software model of the network.
+ *
+ *  Trace file (.nmt), little-endian
+ *    header, 8 bytes
+ *      uint16 format=0x1706, uint16 reserved, uint32 records dropped
+ *    records
+ *      uint8 kind, uint8 module, uint8 register, uint16 length,
+ *      uint32 micros() at the start of the transaction,
+ *      READ, WRITE, READ_ADDR, WRITE_ADDR: uint16 words[length],
+ *        the words read or written
+ *      MARK: char name[length], the NeuroMemAI function which starts
+ */
+/******************************************************************************/
+#ifndef _NeuroMemTrace_h_
+#define _NeuroMemTrace_h_
+
+extern "C" {
+  #include <stdint.h>
+}
+
+class NeuroMemTrace
+{
+	public:
+
+		static const int FORMAT=0x1706;
+		static const int HEADER_SIZE=8; // file header
+		static const int RECORD_SIZE=9; // record before its words or name
+
+		// kinds of records
+		static const uint8_t READ=1;
+		static const uint8_t WRITE=2;
+		static const uint8_t READ_ADDR=3;
+		static const uint8_t WRITE_ADDR=4;
+		static const uint8_t MARK=5;
+
+		NeuroMemTrace(uint8_t buffer[], long size);
+		void clear();
+		void record(uint8_t kind, uint8_t mod, uint8_t reg, unsigned long time, int length, const int data[]);
+		void mark(const char* name, unsigned long time);
+		int save_SDcard(char* filename);
+
+		long used=0; // bytes of records in the buffer
+		unsigned long dropped=0; // oldest records dropped when the buffer is full
+
+	private:
+		uint8_t* buffer;
+		long size;
+		long first=0; // offset of the oldest record
+		long next=0; // offset of the next record
+		bool reserve(long bytes);
+		void put(uint8_t value);
+		uint8_t get(long offset);
+};
+#endif
@@ -0,0 +1,40 @@
+/************************************************************************/
+/*																		
+ *	NeuroMemTransport.h	--	Interface to the registers of a NeuroMem network
+ *	Copyright (c) 2017, General Vision Inc, All rights reserved
+ *
+ *  The NeuroMemAI class accesses the neurons exclusively through this interface.
+ *  NeuroMemSPI implements it for the BrainCard, NeuroShield and NeuroTile boards.
+ *  Other implementations can be a software model of the network running on a
+ *  host computer (see extras/host/NeuroMemEmu.h), or a link to a remote device.
+ *
+ *  The address map follows the NeuroMem Smart protocol:
+ *  Addr[31:24] = module, Addr[7:0] = register
+ *
+ * http://www.general-vision.com/documentation/TM_NeuroMem_Smart_protocol.pdf
+ */
+/******************************************************************************/
+#ifndef _NeuroMemTransport_h_
+#define _NeuroMemTransport_h_
+
+class NeuroMemTransport
+{
+	public:
+
+		// Single register access, data is a 16-bit word
+		virtual int read(unsigned char mod, unsigned char reg)=0;
+		virtual void write(unsigned char mod, unsigned char reg, int data)=0;
+		// Multiple access to a same address, length is expressed in words
+		virtual void writeAddr(long addr, int length, int data[])=0;
+		virtual void readAddr(long addr, int length, int data[])=0;
+		// Split-phase Write_Addr, for the transports which send the data by
+		// DMA or interrupt: startWriteAddr may return before the end of the
+		// transfer, and data must stay unchanged until done() returns true.
+		// By default the transfer is complete when startWriteAddr returns
+		virtual void startWriteAddr(long addr, int length, int data[]) { writeAddr(addr, length, data); }
+		virtual bool done() { return(true); }
+		// Start of a function of NeuroMemAI, for the transports which trace
+		// their transactions
+		virtual void mark(const char*) {}
+};
+#endif
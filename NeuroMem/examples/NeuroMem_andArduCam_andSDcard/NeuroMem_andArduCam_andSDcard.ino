@@ -22,10 +22,12 @@
 // When shutter button is depressed
 //    - if less than 2 seconds ==> learn category 1 and optionally increments
 //    - if more than 2 seconds ==> learn category 0 or background
-//    - optionally, but at the expense of the speed, save to the SD card:
-//        - the feature vectors (vectors.txt, 1 row per vector, also record the category taught)
-//        - the image (imgXcatY.dat, with X the img index, and Y the category taught)
+//    - save to the SD card:
+//        - the feature vectors (SAMPLE00.NML, also record the category taught),
+//          and optionally the image, through a write buffer (NeuroMemLogger.h)
 //        - the knowledge (neurons.knf)
+//    - extras/host/log2csv converts SAMPLE00.NML to vectors.txt (1 row per vector)
+//      and to imgXcatY.ppm images (X the sample index, Y the category taught)
 //    - The ArduCam_Console.exe allows to open these different files
 //
 // Hardware requirements
@@ -51,7 +53,13 @@
 
 // NeuroMem platforms
 #include <NeuroMemAI.h>
+#include <NeuroMemFeatures.h>
+#include <NeuroMemResultCache.h>
+#include <NeuroMemLogger.h>
 NeuroMemAI hNN;
+// the ArduCAM uses the chip select 10 of the BrainCard and NeuroTile,
+// so the platform is not detected, see NeuroMemSPI::detect
+#define HW_NEUROSHIELD 2
 
 int dist=0, cat=0, nid=0, ncount=0;
 int catLearn=1, nextCat=1;
@@ -67,7 +75,9 @@ uint8_t fifo_burst_line[320*2];
 //
 // Definition of the region to monitor continuously
 //
-int rw = 128, rh = 128;
+#define RW 128
+#define RH 128
+int rw = RW, rh = RH;
 int rleft = (fw - rw)/2;
 int rtop = (fh - rh) /2;
 int rright = rleft + rw;
@@ -75,14 +85,20 @@ int rbottom= rtop + rh;
 
 //
 // parameters to extract feature#1: SubSample
-// adjust rw, rh, bw, bh such that vlen < MAX_LEN
+// adjust RW, RH, BW, BH such that vlen <= MAX_LEN
 //
-int bw = 8, bh = 8;
-int hb = rw/bw, vb= rh/bh;
-int vlen= hb*vb;
-long subsample[256]; // buffer
+#define BW 8
+#define BH 8
+NeuroMemSubsample<320, (320 - RW)/2, (240 - RH)/2, BW, BH, RW/BW, RH/BH> subsample;
+int vlen= subsample.LENGTH;
 int subsampleFeat[256]; // int array mapped to values [0-256] for the neurons
 //
+// responses of the last frames, reused while the region does not change
+// by more than CACHE_THRESHOLD (sum of the differences of the components)
+//
+#define CACHE_THRESHOLD 1024
+NeuroMemResultCache<(RW/BW)*(RH/BH), 2> cache(hNN);
+//
 // Access to Camera
 //
 const int SPI_CS_CAM =10;
@@ -92,9 +108,17 @@ UTFT myGLCD(SPI_CS_CAM);
 // Access to SD card
 //
 bool SD_detected=false;
-File SDfile;
 #define SPI_CS_SD 9
 int sampleID=0; // to track the number of learned examples saved to SD card
+//
+// Log of the learned examples, kept open and written by blocks of the buffer
+//
+char logFilename[13]="SAMPLE00.NML"; // the number changes when a log was cut by a power off
+#define LOG_FLUSH 16 // examples between two flushes, lost at most on a power off
+//#define LOG_FRAMES // also log the frame of each example, RGB565 as read, 153.6 KB each
+uint8_t logBuffer[2048];
+NeuroMemLogger logger(logBuffer, sizeof(logBuffer));
+bool logging=false;
 
 void setup() {
 
@@ -127,6 +151,14 @@ void setup() {
   if (SD.begin(SPI_CS_SD))
   {
     SD_detected=true;
+    // append to the log of the previous start, or to the next log
+    // when it ends inside a record, after a power off
+    for (int i = 0 ; (i < 100) && (!logging) ; i++)
+    {
+      logFilename[6] = '0' + i / 10;
+      logFilename[7] = '0' + i % 10;
+      logging=(logger.begin(logFilename)==0);
+    }
   }
   else
   {
@@ -149,14 +181,11 @@ void setup() {
   }
   
   // Initialize the NeuroMem neural network
-  int NMplatform=0;
-  Serial.print("\nSelect your NeuroMem platform:\n\t1 - BrainCard\n\t2 - NeuroShield\n\t3 - NeuroTile\n");
-  while(Serial.available() <1);
-  NMplatform = Serial.read() - 48;      
-  if (hNN.begin(NMplatform) == 0) 
+  if (hNN.begin(HW_NEUROSHIELD) == 0) 
   {
     Serial.print("\nYour NeuroMem_Smart device is initialized! ");
     Serial.print("\nThere are "); Serial.print(hNN.navail); Serial.print(" neurons\n");     
+    cache.threshold=CACHE_THRESHOLD;
   }
   else 
   {
@@ -181,7 +210,7 @@ void loop() {
       myGLCD.resetXY();
       myCAM.set_mode(CAM2LCD_MODE);
       while (!myCAM.get_bit(ARDUCHIP_TRIG, VSYNC_MASK));      
-      getFeatureVectors();
+      getFeatureVectors(false);
       recognize();
     } 
     else if (myCAM.get_bit(ARDUCHIP_TRIG, SHUTTER_MASK))
@@ -193,7 +222,6 @@ void loop() {
         tmp=millis() - timer_start;
         //Serial.print("time="); Serial.println(tmp);        
       }
-      getFeatureVectors(); 
       if (tmp > 2000)
       {
         catLearn=0;
@@ -206,21 +234,25 @@ void loop() {
         // but you may have to teach background examples (pressing the shutter more than 2 sec)
         // to avoid that the neurons overgeneralize
       }
+      getFeatureVectors(logging);
       learn(catLearn);
       if (SD_detected==true)
       {
-          // time consuming options...for debug or further analysis
-          int error=hNN.saveKnowledge_SDcard("neurons.knf");
+          int error=hNN.checkpointKnowledge_SDcard("neurons.knf");
           if (error!=0) Serial.print("\n\nError saving knowledge to SD card\n");
-          //saveVectors(catLearn); Serial.print("\n\nSaving vectors to SD card\n");
-          //saveImage(catLearn);
+          if (logging)
+          {
+            error=logger.logVector(subsampleFeat, vlen, catLearn, 1, millis());
+            if ((error==0) && ((sampleID + 1) % LOG_FLUSH==0)) error=logger.flush();
+            if (error!=0) Serial.print("\n\nError saving vectors to SD card\n");
+          }
           sampleID++;
       }
     }
   }
 }
 
-void getFeatureVectors() {
+void getFeatureVectors(bool logFrame) {
   myCAM.flush_fifo();
   myCAM.clear_fifo_flag();
   myCAM.start_capture();
@@ -233,55 +265,38 @@ void getFeatureVectors() {
   myCAM.set_fifo_burst();//Set fifo burst mode
   
   // Read captured image as BMP565 format (320x240x 2 bytes from FIFO)
-  // extract the three features on the fly
-  char VH, VL;
-  int indexFeat1X, indexFeat1Y, index = 0;
-  int color, r, g, b, greylevel, maxgrey=0, mingrey=255;
-  for (int i = 0; i < vlen; i++) subsample[i] = 0; 
+  // extract the features on the fly, one line at a time
+  // (NeuroMemRGBHistogram and NeuroMemEdgeHistogram accept the same lines)
+  subsample.begin();
+#ifdef LOG_FRAMES
+  if (logFrame) logger.beginFrame(fw, fh, catLearn, 1, millis());
+#endif
   for (int y = 0 ; y < fh ; y++)
   {
     SPI.transfer(fifo_burst_line, fw*2);//read one line from spi  
-    for (int x = 0 ; x < fw ; x++)
+    subsample.addLine(fifo_burst_line);
+#ifdef LOG_FRAMES
+    if (logFrame)
     {
-      VH = fifo_burst_line[x*2];
-      VL = fifo_burst_line[x*2+1];
-      color = (VH << 8) + VL;
-
-      if (y >= rtop && y < rbottom)
-      {       
-        indexFeat1Y= (y - rtop) / bh;
-        if (x >= rleft && x < rright)
-        {             
-          r = ((color >> 11) & 0x1F);
-          g = ((color >> 5) & 0x1F);
-          b = (color & 0x001F);
-          greylevel= r+g+b; // byte value
-          if (greylevel > maxgrey) maxgrey=greylevel;
-          else if (greylevel < mingrey) mingrey=greylevel;
-
-          indexFeat1X= (x - rleft) / bw;
-          if ((indexFeat1X < hb) & (indexFeat1Y < vb))
-          {
-              index = (indexFeat1Y * hb) + indexFeat1X;
-              subsample[index] = subsample[index] + greylevel;
-          }
-        }
-      }
+      // the SD card shares the bus: release the FIFO while the
+      // logger may write, then resume the burst at the next line
+      myCAM.CS_HIGH();
+      logger.addLine(fifo_burst_line);
+      myCAM.CS_LOW();
+      myCAM.set_fifo_burst();
     }
+#endif
   }
   
   myCAM.CS_HIGH();
   
-  //Serial.print("\nBlock intensity Max="); Serial.print(maxgrey); Serial.print("\tMin="); Serial.println(mingrey);
-  for (int i = 0; i < vlen; i++) subsampleFeat[i] = (byte)(subsample[i] / (bw * bh));
-  // or to normalized
-  // for (int i = 0; i < vlen; i++) subsampleFeat[i] = (byte)(((subsample[i] / (bw * bh))- mingrey)*255 / (maxgrey-mingrey));
+  subsample.getVector(subsampleFeat);
 }
 
 void recognize() 
 {
   // recognize feature vector #1 or subsample vector
-  hNN.classify(subsampleFeat, vlen, &dist, &cat, &nid);
+  cache.classify(subsampleFeat, vlen, &dist, &cat, &nid);
   // recognize feature vector #2 or histogram rgb
    
   char tmpStr[10];
@@ -326,86 +341,6 @@ void learn(int Category)
   delay(100); // to sustain the display
 }
 
-void saveVectors(int Category)
-{
-  // Save to a format compatible with the NeuroMem Knowledge Builder
-  // Each feature type is assigned a different context
-  char vectFilename[12] = "vectors.txt";
-  if (sampleID==0)
-  {
-        if (SD.exists(vectFilename)) SD.remove(vectFilename);
-  }
-    SDfile = SD.open(vectFilename, FILE_WRITE);
-    if(! SDfile)
-    {
-      Serial.print(vectFilename); Serial.println(" file open failed");
-      return;
-   }
-    Serial.print("\nSaving to SD card vector#"); Serial.println(sampleID);
-    // header for NeuroMem Knowledge Builder
-    if (sampleID==0)SDfile.print("patternID, parentID, Context, GTcategory, v1\n");
-    SDfile.print(sampleID); SDfile.print(","); // patternID
-    SDfile.print("0,");  // parentID
-    SDfile.print("1,"); // context
-    SDfile.print(Category); SDfile.print(",");
-    SDfile.print(vlen); SDfile.print(",");
-    for (int i=0; i< vlen; i++) {SDfile.print(subsampleFeat[i]); SDfile.print(",");}
-    SDfile.print("\n");
-    SDfile.close();
-    Serial.println("Vectors saved!");
-}
-
-void saveImage(int Category)
-{
- //Construct a file name
- char imgFilename[20]="img";
- char strtmp[10];
- itoa(sampleID, strtmp, 10);
- strcat(imgFilename, strtmp);
- strcat(imgFilename, "cat");
- itoa(Category, strtmp, 10);
- strcat(imgFilename, strtmp);
- strcat(imgFilename, ".dat");
- 
- if (SD.exists(imgFilename)) SD.remove(imgFilename);
- //SDfile = SD.open(str, O_WRITE | O_CREAT | O_TRUNC);
- SDfile = SD.open(imgFilename, FILE_WRITE);
- if(! SDfile){
-  Serial.print(imgFilename); Serial.println(" file open failed");
-  return;
- }
-   Serial.print("\nSaving to SD card "); Serial.print(imgFilename);
-
-  myCAM.flush_fifo();
-  myCAM.clear_fifo_flag();
-  myCAM.start_capture();
-  while (!myCAM.get_bit(ARDUCHIP_TRIG, CAP_DONE_MASK));
-  //Serial.println("Capture Done!");
-  
-  myCAM.read_fifo(); // Read the first dummy byte
-  
-  byte pixeline[320]; // fw=320
-  char VH, VL;
-  int color, r, g, b, greylevel;
-  for (int y = 0 ; y < fh ; y++)
-  {
-    for (int x = 0 ; x < fw ; x++)
-    {
-      VL = myCAM.read_fifo();
-      VH = myCAM.read_fifo();
-      color = (VH << 8) + VL;            
-      r = ((color >> 11) & 0x1F);
-      g = ((color >> 5) & 0x3F);
-      b = (color & 0x001F);
-      greylevel= r+g+b;
-      pixeline[x] = (byte)(greylevel);        
-    }
-    SDfile.write(pixeline, fw);
-  }
-  SDfile.close();
-  Serial.println("\nImage saved!");
- }
-
 void displayLCD_res(char* Str, int x, int y)
 {
   myCAM.set_mode(MCU2LCD_MODE);
@@ -0,0 +1,34 @@
+/************************************************************************/
+/*																		
+ *	Arduino.h	--	Minimal Arduino core to build the NeuroMem library
+ *	                on a host computer (Linux, macOS)
+ *
+ *  Only the functions used by the NeuroMem library are provided.
+ *  Time functions return the host monotonic clock.
+ */
+/******************************************************************************/
+#ifndef _ArduinoHost_h_
+#define _ArduinoHost_h_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+unsigned long millis();
+unsigned long micros();
+
+#endif
@@ -0,0 +1,198 @@
+/************************************************************************/
+/*																		
+ *	ArduinoHost.cpp	--	Minimal Arduino core, SPI and SD libraries
+ *	                    to build the NeuroMem library on a host computer
+ */
+/******************************************************************************/
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "SD.h"
+
+#include <chrono>
+#include <thread>
+#include <sys/stat.h>
+
+SPIClass SPI;
+SDClass SD;
+
+static const std::chrono::steady_clock::time_point startTime=std::chrono::steady_clock::now();
+
+// ------------------------------------------------------------ 
+// Digital pins are routed to the chip select of the emulated
+// SPI devices, others are ignored
+// ------------------------------------------------------------ 
+void pinMode(uint8_t, uint8_t)
+{
+}
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+	SPI.chipSelect(pin, val);
+}
+int digitalRead(uint8_t)
+{
+	return(LOW);
+}
+void delay(unsigned long ms)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+void delayMicroseconds(unsigned int us)
+{
+	std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+unsigned long millis()
+{
+	return((unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count());
+}
+unsigned long micros()
+{
+	return((unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count());
+}
+
+// ------------------------------------------------------------ 
+// SPI bus
+// ------------------------------------------------------------ 
+void SPIClass::attach(uint8_t pin, SPIDevice* device)
+{
+	for (int i=0; i<ndevices; i++)
+	{
+		if (pins[i]==pin) { devices[i]=device; return; }
+	}
+	if (ndevices==MAX_DEVICES) return;
+	pins[ndevices]=pin;
+	devices[ndevices]=device;
+	ndevices++;
+}
+void SPIClass::chipSelect(uint8_t pin, uint8_t val)
+{
+	for (int i=0; i<ndevices; i++)
+	{
+		if ((pins[i]!=pin) || (devices[i]==0)) continue;
+		if (val==LOW)
+		{
+			selected=devices[i];
+			selected->select(true);
+		}
+		else if (selected==devices[i])
+		{
+			selected->select(false);
+			selected=0;
+		}
+		return;
+	}
+}
+uint8_t SPIClass::transfer(uint8_t data)
+{
+	if (selected==0) return(0);
+	return(selected->transfer(data));
+}
+void SPIClass::transfer(void* buf, size_t count)
+{
+	uint8_t* p=(uint8_t*)buf;
+	for (size_t i=0; i<count; i++) p[i]=transfer(p[i]);
+}
+
+// ------------------------------------------------------------ 
+// SD card, mapped to a directory of the host
+// ------------------------------------------------------------ 
+size_t File::write(uint8_t b)
+{
+	return(write(&b, 1));
+}
+size_t File::write(const uint8_t* buf, size_t size)
+{
+	if ((f==0) || !(mode & O_WRITE)) return(0);
+	if (mode & O_APPEND) fseek(f, 0, SEEK_END);
+	return(fwrite(buf, 1, size, f));
+}
+int File::read()
+{
+	uint8_t b;
+	if (read(&b, 1)!=1) return(-1);
+	return(b);
+}
+int File::read(void* buf, uint16_t nbyte)
+{
+	if (f==0) return(-1);
+	return((int)fread(buf, 1, nbyte, f));
+}
+int File::peek()
+{
+	if (f==0) return(-1);
+	int c=fgetc(f);
+	if (c!=EOF) ungetc(c, f);
+	return(c==EOF ? -1 : c);
+}
+int File::available()
+{
+	if (f==0) return(0);
+	uint32_t remaining=size() - position();
+	return(remaining > 0x7FFF ? 0x7FFF : (int)remaining);
+}
+void File::flush()
+{
+	if (f!=0) fflush(f);
+}
+bool File::seek(uint32_t pos)
+{
+	if (f==0) return(false);
+	return(fseek(f, pos, SEEK_SET)==0);
+}
+uint32_t File::position()
+{
+	if (f==0) return(0);
+	return((uint32_t)ftell(f));
+}
+uint32_t File::size()
+{
+	if (f==0) return(0);
+	long pos=ftell(f);
+	fseek(f, 0, SEEK_END);
+	long end=ftell(f);
+	fseek(f, pos, SEEK_SET);
+	return((uint32_t)end);
+}
+void File::close()
+{
+	if (f!=0) fclose(f);
+	f=0;
+}
+
+bool SDClass::begin(uint8_t, const char* rootDir)
+{
+	if (rootDir!=0) snprintf(root, sizeof(root), "%s/", rootDir);
+	return(true);
+}
+void SDClass::path(const char* filename, char* out, size_t len)
+{
+	snprintf(out, len, "%s%s", root, filename);
+}
+File SDClass::open(const char* filename, uint8_t mode)
+{
+	char name[512];
+	path(filename, name, sizeof(name));
+	FILE* f=0;
+	if (mode & O_WRITE)
+	{
+		if ((mode & O_TRUNC) || ((mode & O_CREAT) && !exists(filename))) f=fopen(name, "w+b");
+		else f=fopen(name, "r+b");
+		if ((f!=0) && (mode & O_APPEND)) fseek(f, 0, SEEK_END);
+	}
+	else f=fopen(name, "rb");
+	if (f==0) return(File());
+	return(File(f, mode));
+}
+bool SDClass::exists(const char* filename)
+{
+	char name[512];
+	path(filename, name, sizeof(name));
+	struct stat st;
+	return(stat(name, &st)==0);
+}
+bool SDClass::remove(const char* filename)
+{
+	char name[512];
+	path(filename, name, sizeof(name));
+	return(::remove(name)==0);
+}
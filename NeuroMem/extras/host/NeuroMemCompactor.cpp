@@ -0,0 +1,175 @@
+/************************************************************************/
+/*
+ *	NeuroMemCompactor.cpp	--	Merge and prune knowledge files on a host
+ */
+/******************************************************************************/
+
+#include "NeuroMemCompactor.h"
+#include "NeuroMemKernels.h"
+#include "NeuroMemKnowledgeMap.h"
+#include "NeuroMemSearch.h"
+#include <NeuroMemKnowledge.h>
+
+#include <stdio.h>
+#include <string.h>
+
+// ------------------------------------------------------------ //
+//    Constructor to the class NeuroMemCompactor
+// ------------------------------------------------------------
+NeuroMemCompactor::NeuroMemCompactor(int capacity) : neurons(capacity)
+{
+}
+// ------------------------------------------------------------
+// Append the neurons of a knowledge file
+// ------------------------------------------------------------
+int NeuroMemCompactor::merge(const char* filename)
+{
+	NeuroMemKnowledgeMap knowledge;
+	int error=knowledge.open(filename);
+	if (error!=0) return(error);
+	if (knowledge.neuronSize > NEURONSIZE) return(5);
+	if (neurons.count + knowledge.size() > neurons.capacity) return(6);
+	for (int i=0; i<knowledge.size(); i++)
+	{
+		int n=neurons.count++;
+		int length=knowledge.length(i);
+		memset(neurons.model(n), 0, NEURONSIZE);
+		memcpy(neurons.model(n), knowledge.model(i), length);
+		neurons.ncr[n]=(uint8_t)knowledge.NCR(i);
+		neurons.aif[n]=(uint16_t)knowledge.AIF(i);
+		neurons.minif[n]=(uint16_t)knowledge.MINIF(i);
+		neurons.cat[n]=(uint16_t)knowledge.CAT(i);
+		while ((length > 0) && (neurons.model(n)[length - 1]==0)) length--;
+		used.push_back(length);
+	}
+	return(0);
+}
+// ------------------------------------------------------------
+// Remove the neurons whose influence field is inside the one of
+// a neuron of the same category, context and norm. The kernels
+// stop as soon as the distance exceeds the difference of the AIF
+// ------------------------------------------------------------
+int NeuroMemCompactor::removeShadowed()
+{
+	const NeuroMemKernels& kernels=neuroMemKernels();
+	std::vector<bool> removed(neurons.count, false);
+	int count=0;
+	// from the last neuron, so the first one of identical neurons is kept
+	for (int n=neurons.count - 1; n>=0; n--)
+	{
+		for (int m=0; m<neurons.count; m++)
+		{
+			if ((m==n) || (removed[m]) || (neurons.ncr[m]!=neurons.ncr[n])) continue;
+			if ((neurons.cat[m] & 0x7FFF)!=(neurons.cat[n] & 0x7FFF)) continue;
+			int limit=neurons.aif[m] - neurons.aif[n];
+			if (limit < 0) continue;
+			int length=used[n] > used[m] ? used[n] : used[m];
+			int d=(neurons.ncr[n] & 0x80) ? kernels.LSup(neurons.model(n), neurons.model(m), length, limit)
+				: kernels.L1(neurons.model(n), neurons.model(m), length, limit);
+			if (d <= limit)
+			{
+				removed[n]=true;
+				count++;
+				break;
+			}
+		}
+	}
+	remove(removed);
+	return(count);
+}
+// ------------------------------------------------------------
+// Count the validation vectors of which each neuron is the top
+// firing neuron, in the context of the vector
+// ------------------------------------------------------------
+void NeuroMemCompactor::score(const NeuroMemVectors& validation, std::vector<int>& wins)
+{
+	wins.assign(neurons.count, 0);
+	for (size_t v=0; v<validation.size(); v++)
+	{
+		NeuroMemHit hit;
+		if (neuroMemTopK(neurons, 0, neurons.count, validation.vector(v), validation.length[v],
+			validation.context[v], false, 1, &hit)==1) wins[hit.nid - 1]++;
+	}
+}
+// ------------------------------------------------------------
+// Remove the neurons of the contexts of the validation set which
+// are the top firing neuron of none of its vectors
+// ------------------------------------------------------------
+int NeuroMemCompactor::removeUnused(const NeuroMemVectors& validation)
+{
+	std::vector<int> wins;
+	score(validation, wins);
+	bool contexts[128];
+	bool all=false; // context 0 activates all the neurons
+	for (int c=0; c<128; c++) contexts[c]=false;
+	for (size_t v=0; v<validation.size(); v++)
+	{
+		contexts[validation.context[v] & 0x7F]=true;
+		if ((validation.context[v] & 0x7F)==0) all=true;
+	}
+	std::vector<bool> removed(neurons.count, false);
+	int count=0;
+	for (int n=0; n<neurons.count; n++)
+	{
+		if ((wins[n]==0) && ((all) || (contexts[neurons.ncr[n] & 0x7F])))
+		{
+			removed[n]=true;
+			count++;
+		}
+	}
+	remove(removed);
+	return(count);
+}
+// ------------------------------------------------------------
+// Keep the neurons which are not removed, in the same order
+// ------------------------------------------------------------
+void NeuroMemCompactor::remove(const std::vector<bool>& removed)
+{
+	int kept=0;
+	for (int n=0; n<neurons.count; n++)
+	{
+		if (removed[n]) continue;
+		if (kept!=n)
+		{
+			memcpy(neurons.model(kept), neurons.model(n), NEURONSIZE);
+			neurons.ncr[kept]=neurons.ncr[n];
+			neurons.aif[kept]=neurons.aif[n];
+			neurons.minif[kept]=neurons.minif[n];
+			neurons.cat[kept]=neurons.cat[n];
+			used[kept]=used[n];
+		}
+		kept++;
+	}
+	neurons.count=kept;
+	used.resize(kept);
+}
+// ------------------------------------------------------------
+// Write the neurons in the V2 format, as saveKnowledge_SDcard
+// ------------------------------------------------------------
+int NeuroMemCompactor::save(const char* filename, bool usedLength)
+{
+	FILE* f=fopen(filename, "wb");
+	if (f==0) return(3);
+	int flags=usedLength ? NeuroMemKnowledge::FLAG_USEDLEN : 0;
+	uint8_t header[NeuroMemKnowledge::HEADER_SIZE];
+	NeuroMemKnowledge::packHeader(header, NEURONSIZE, neurons.count, flags);
+	bool ok=fwrite(header, 1, sizeof(header), f)==sizeof(header);
+	int neuron[NEURONSIZE + 4];
+	uint8_t record[NeuroMemKnowledge::REGISTERS_SIZE + 2 + NEURONSIZE];
+	uint32_t checksum=0;
+	for (int n=0; n<neurons.count; n++)
+	{
+		neuron[0]=neurons.ncr[n];
+		for (int j=0; j<NEURONSIZE; j++) neuron[j + 1]=neurons.model(n)[j];
+		neuron[NEURONSIZE + 1]=neurons.aif[n];
+		neuron[NEURONSIZE + 2]=neurons.minif[n];
+		neuron[NEURONSIZE + 3]=neurons.cat[n];
+		int length=NeuroMemKnowledge::packNeuron(neuron, NEURONSIZE, flags, record);
+		checksum=NeuroMemKnowledge::checksum(checksum, record, length);
+		ok=ok && (fwrite(record, 1, length, f)==(size_t)length);
+	}
+	NeuroMemKnowledge::put32(record, checksum);
+	ok=ok && (fwrite(record, 1, NeuroMemKnowledge::CHECKSUM_SIZE, f)==NeuroMemKnowledge::CHECKSUM_SIZE);
+	if (fclose(f)!=0) ok=false;
+	return(ok ? 0 : 3);
+}
@@ -0,0 +1,68 @@
+/************************************************************************/
+/*
+ *	NeuroMemCompactor.h	--	Merge and prune knowledge files on a host
+ *
+ *  Gathers the neurons of several V2 knowledge files, one after the other
+ *  in the order of the files, and removes the neurons which do not change
+ *  the decisions of the network:
+ *
+ *    NeuroMemCompactor compactor(1152);
+ *    compactor.merge("monday.knf");
+ *    compactor.merge("tuesday.knf");
+ *    compactor.removeShadowed();
+ *    compactor.removeUnused(validation); // optional, see NeuroMemVectors.h
+ *    compactor.save("neurons.knf");
+ *
+ *  removeShadowed removes a neuron when the influence field of another
+ *  neuron of the same category, context and norm contains its own:
+ *  distance of the models + AIF <= AIF of the other neuron. Wherever the
+ *  removed neuron fired, the other one fires too, so the unknown and
+ *  identified vectors keep their status and category, the uncertain ones
+ *  stay uncertain. Identical neurons are shadowed by each other, the first
+ *  one is kept.
+ *
+ *  removeUnused removes the neurons of the contexts of a validation set
+ *  which are the top firing neuron (RBF mode) of none of its vectors. The
+ *  top firing neuron of each validation vector is kept, so its category
+ *  and distance do not change. A vector which was uncertain can become
+ *  identified, and the vectors outside the validation set can lose their
+ *  firing neurons: the validation set must cover the inputs of the
+ *  application.
+ */
+/******************************************************************************/
+#ifndef _NeuroMemCompactor_h_
+#define _NeuroMemCompactor_h_
+
+#include "NeuroMemStore.h"
+#include "NeuroMemVectors.h"
+
+#include <vector>
+
+class NeuroMemCompactor
+{
+	public:
+
+		static const int NEURONSIZE=256; // memory capacity of each neuron in byte
+
+		NeuroMemCompactor(int capacity);
+
+		NeuroMemStore neurons; // NCR, AIF, MINIF and CAT are the ones of the files
+
+		// Return 0, the error codes of NeuroMemKnowledgeMap::open,
+		// 5 if the neuron size of the file is larger than NEURONSIZE,
+		// 6 if the neurons do not fit in the capacity
+		int merge(const char* filename);
+		// return the number of neurons removed
+		int removeShadowed();
+		int removeUnused(const NeuroMemVectors& validation);
+		// number of validation vectors of which each neuron is the top firing neuron
+		void score(const NeuroMemVectors& validation, std::vector<int>& wins);
+		// Return 0, or 3 if the file cannot be written
+		int save(const char* filename, bool usedLength=true);
+
+	private:
+
+		std::vector<int> used; // used length of each neuron
+		void remove(const std::vector<bool>& removed);
+};
+#endif
@@ -0,0 +1,375 @@
+/************************************************************************/
+/*																		
+ *	NeuroMemEmu.cpp	--	Software model of a NeuroMem network
+ *
+ *  Refer to the NeuroMem Technology Reference Guide for the
+ *  description of the registers
+ * http://www.general-vision.com/documentation/TM_NeuroMem_Technology_Reference_Guide.pdf
+ */
+/******************************************************************************/
+
+#include "NeuroMemEmu.h"
+#include "NeuroMemKernels.h"
+
+#include <string.h>
+#include <algorithm>
+
+// Modules of the NeuroMem hardware (Byte #0 in map address)
+static const int mod_NM=0x01;
+static const int mod_FPGA=0x02;
+
+// Registers of a NeuroMem network (Byte #3 in map address)
+static const int NM_NCR=0x00;
+static const int NM_COMP=0x01;
+static const int NM_LCOMP=0x02;
+static const int NM_DIST=0x03;
+static const int NM_INDEXCOMP=0x03;
+static const int NM_CAT=0x04;
+static const int NM_AIF=0x05;
+static const int NM_MINIF=0x06;
+static const int NM_MAXIF=0x07;
+static const int NM_TESTCOMP=0x08;
+static const int NM_TESTCAT=0x09;
+static const int NM_NID=0x0A;
+static const int NM_GCR=0x0B;
+static const int NM_RESETCHAIN=0x0C;
+static const int NM_NSR=0x0D;
+static const int NM_POWERSAVE=0x0E;
+static const int NM_NCOUNT=0x0F;
+static const int NM_FORGET=0x0F;
+
+// Network Status Register
+static const int NSR_UNC=0x04;
+static const int NSR_ID=0x08;
+static const int NSR_SR=0x10;
+static const int NSR_KNN=0x20;
+
+static const int CAT_DEGENERATED=0x8000;
+
+// ------------------------------------------------------------ //
+//    Constructor to the class NeuroMemEmu
+// ------------------------------------------------------------ 
+NeuroMemEmu::NeuroMemEmu(int capacity) : capacity(capacity), neurons(capacity)
+{
+	dist=new int[capacity];
+	firing=new int[capacity];
+	reset();
+}
+NeuroMemEmu::~NeuroMemEmu()
+{
+	delete[] dist;
+	delete[] firing;
+}
+// ------------------------------------------------------------ 
+// Power-on reset: clear the memory of the neurons and
+// set the default value of the registers
+// ------------------------------------------------------------ 
+void NeuroMemEmu::reset()
+{
+	neurons.clear();
+	memset(vector, 0, sizeof(vector));
+	nsr=0;
+	forget();
+}
+// ------------------------------------------------------------ 
+// Un-commit all the neurons and reset GCR=1, MINIF=2, MAXIF=0x4000
+// The memory of the neurons is not cleared
+// ------------------------------------------------------------ 
+void NeuroMemEmu::forget()
+{
+	memset(neurons.cat, 0, capacity * sizeof(uint16_t));
+	neurons.count=0;
+	gcr=1;
+	minif=2;
+	maxif=0x4000;
+	status=0;
+	index=0;
+	vlen=0;
+	chain=0;
+	nfiring=0;
+	sorted=true;
+	started=false;
+	current=-1;
+}
+// --------------------------------------------------------
+// Compute the distance of the active neurons and the
+// list of firing neurons after the last component
+// The distance is exact below the AIF and MAXIF, which
+// is all that the readout and the learning rule need
+//---------------------------------------------------------
+void NeuroMemEmu::evaluate()
+{
+	const NeuroMemKernels& kernels=neuroMemKernels();
+	int context=gcr & 0x7F;
+	int firstCat=-1;
+	bool knn=(nsr & NSR_KNN)!=0;
+	status=0;
+	nfiring=0;
+	for (int i=0; i<neurons.count; i++)
+	{
+		int ncr=neurons.ncr[i];
+		if ((context!=0) && ((ncr & 0x7F)!=context))
+		{
+			dist[i]=-1;
+			continue;
+		}
+		int aif=neurons.aif[i];
+		int limit=knn ? NM_NOLIMIT : (aif > maxif ? aif : maxif);
+		dist[i]=(ncr & 0x80) ? kernels.LSup(vector, neurons.model(i), vlen, limit)
+			: kernels.L1(vector, neurons.model(i), vlen, limit);
+		if ((knn) || (dist[i] < aif))
+		{
+			firing[nfiring++]=i;
+			int c=neurons.cat[i] & 0x7FFF;
+			if (firstCat<0) firstCat=c;
+			else if (c!=firstCat) status=NSR_UNC;
+		}
+	}
+	if ((nfiring > 0) && (status==0)) status=NSR_ID;
+	sorted=false;
+	started=false;
+	current=-1;
+}
+// --------------------------------------------------------
+// Move to the next firing neuron by increasing distance,
+// then category, then identifier
+// The firing neurons are kept in a heap, so reading K
+// neurons out of N costs N + K.log(N)
+// Return -1 when all the firing neurons have been read
+//---------------------------------------------------------
+int NeuroMemEmu::next()
+{
+	const int* d=dist;
+	const uint16_t* c=neurons.cat;
+	// heap order: the top is the first neuron to read
+	auto after=[d, c](int a, int b)
+	{
+		if (d[a]!=d[b]) return(d[a] > d[b]);
+		if ((c[a] & 0x7FFF)!=(c[b] & 0x7FFF)) return((c[a] & 0x7FFF) > (c[b] & 0x7FFF));
+		return(a > b);
+	};
+	if (!sorted)
+	{
+		std::make_heap(firing, firing + nfiring, after);
+		sorted=true;
+	}
+	started=true;
+	current=-1;
+	if (nfiring > 0)
+	{
+		std::pop_heap(firing, firing + nfiring, after);
+		current=firing[--nfiring];
+	}
+	return(current);
+}
+// --------------------------------------------------------
+// Learn the last broadcast vector with the RCE rule
+// - the firing neurons of another category shrink their
+//   influence field to the distance, clipped to their MINIF
+// - a new neuron is committed unless a firing neuron has
+//   the same category, with an influence field equal to the
+//   distance of the closest neuron of another category,
+//   clipped to MINIF and MAXIF
+// Category 0 shrinks the firing neurons and commits nothing
+//---------------------------------------------------------
+void NeuroMemEmu::learn(int category)
+{
+	if (vlen==0) return;
+	int c=category & 0x7FFF;
+	bool recognized=false;
+	int nearest=maxif;
+	for (int i=0; i<neurons.count; i++)
+	{
+		if (dist[i] < 0) continue;
+		int ci=neurons.cat[i] & 0x7FFF;
+		if (ci!=c)
+		{
+			if (dist[i] < nearest) nearest=dist[i];
+			if (dist[i] < neurons.aif[i])
+			{
+				neurons.aif[i]=(uint16_t)dist[i];
+				if (neurons.aif[i] < neurons.minif[i])
+				{
+					neurons.aif[i]=neurons.minif[i];
+					neurons.cat[i]|=CAT_DEGENERATED;
+				}
+			}
+		}
+		else if (dist[i] < neurons.aif[i]) recognized=true;
+	}
+	if ((c!=0) && (!recognized) && (neurons.count < capacity))
+	{
+		// the components were written to the ready-to-learn neuron during the broadcast
+		int n=neurons.count;
+		neurons.ncr[n]=(uint8_t)gcr;
+		neurons.minif[n]=(uint16_t)minif;
+		neurons.aif[n]=(uint16_t)nearest;
+		neurons.cat[n]=(uint16_t)c;
+		if (nearest < minif)
+		{
+			neurons.aif[n]=(uint16_t)minif;
+			neurons.cat[n]|=CAT_DEGENERATED;
+		}
+		dist[n]=-1;
+		neurons.count++;
+	}
+	sorted=true;
+	nfiring=0;
+	current=-1;
+}
+// ---------------------------------------------------------
+// Register access in normal mode
+// ---------------------------------------------------------
+int NeuroMemEmu::readNormal(unsigned char reg)
+{
+	switch(reg)
+	{
+		case NM_DIST: return(next() < 0 ? 0xFFFF : dist[current]);
+		case NM_CAT:
+			if (!started) next();
+			return(current < 0 ? 0xFFFF : neurons.cat[current]);
+		case NM_NID: return(current < 0 ? 0xFFFF : current + 1);
+		case NM_AIF: return(current < 0 ? 0xFFFF : neurons.aif[current]);
+		case NM_NCR: return(current < 0 ? 0 : neurons.ncr[current]);
+		case NM_MINIF: return(minif);
+		case NM_MAXIF: return(maxif);
+		case NM_GCR: return(gcr);
+		case NM_NSR: return(nsr | status);
+		case NM_NCOUNT: return(neurons.count);
+		case NM_POWERSAVE: return(fpgaRev);
+	}
+	return(0);
+}
+void NeuroMemEmu::writeNormal(unsigned char reg, int data)
+{
+	switch(reg)
+	{
+		case NM_COMP:
+		case NM_LCOMP:
+			if (index < NEURONSIZE)
+			{
+				vector[index]=(unsigned char)data;
+				// the ready-to-learn neuron stores the components
+				if (neurons.count < capacity) neurons.model(neurons.count)[index]=(unsigned char)data;
+				index++;
+			}
+			if (reg==NM_LCOMP)
+			{
+				vlen=index;
+				index=0;
+				evaluate();
+			}
+			break;
+		case NM_INDEXCOMP: index=data & 0xFF; break;
+		case NM_CAT: learn(data); break;
+		case NM_MINIF: minif=data & 0xFFFF; break;
+		case NM_MAXIF: maxif=data & 0xFFFF; break;
+		case NM_GCR: gcr=data & 0xFF; break;
+		case NM_TESTCOMP:
+			for (int i=0; i<capacity; i++) neurons.model(i)[index]=(unsigned char)data;
+			break;
+		case NM_TESTCAT:
+			for (int i=0; i<capacity; i++) neurons.cat[i]=(uint16_t)data;
+			break;
+		case NM_RESETCHAIN: chain=0; index=0; break;
+		case NM_NSR: nsr=data & (NSR_SR | NSR_KNN); index=0; break;
+		case NM_FORGET: forget(); break;
+	}
+}
+// ---------------------------------------------------------
+// Register access in Save and Restore mode
+// ---------------------------------------------------------
+int NeuroMemEmu::readSR(unsigned char reg)
+{
+	switch(reg)
+	{
+		case NM_GCR: return(gcr);
+		case NM_MAXIF: return(maxif);
+		case NM_NSR: return(nsr);
+		case NM_NCOUNT: return(neurons.count);
+		case NM_POWERSAVE: return(fpgaRev);
+	}
+	if (chain >= capacity) return(0xFFFF);
+	int value=0;
+	switch(reg)
+	{
+		case NM_NCR: value=neurons.ncr[chain]; break;
+		case NM_COMP:
+		case NM_LCOMP:
+			if (index < NEURONSIZE) value=neurons.model(chain)[index++];
+			break;
+		case NM_AIF: value=neurons.aif[chain]; break;
+		case NM_MINIF: value=neurons.minif[chain]; break;
+		case NM_NID: value=chain + 1; break;
+		case NM_CAT:
+			value=neurons.cat[chain];
+			chain++;
+			index=0;
+			break;
+	}
+	return(value);
+}
+void NeuroMemEmu::writeSR(unsigned char reg, int data)
+{
+	switch(reg)
+	{
+		case NM_INDEXCOMP: index=data & 0xFF; return;
+		case NM_GCR: gcr=data & 0xFF; return;
+		case NM_MAXIF: maxif=data & 0xFFFF; return;
+		case NM_TESTCOMP:
+			for (int i=0; i<capacity; i++) neurons.model(i)[index]=(unsigned char)data;
+			return;
+		case NM_TESTCAT:
+			for (int i=0; i<capacity; i++) neurons.cat[i]=(uint16_t)data;
+			return;
+		case NM_RESETCHAIN: chain=0; index=0; return;
+		case NM_NSR: nsr=data & (NSR_SR | NSR_KNN); index=0; return;
+		case NM_FORGET: forget(); return;
+	}
+	if (chain >= capacity) return;
+	switch(reg)
+	{
+		case NM_NCR: neurons.ncr[chain]=(uint8_t)data; break;
+		case NM_COMP:
+		case NM_LCOMP:
+			if (index < NEURONSIZE) neurons.model(chain)[index++]=(unsigned char)data;
+			break;
+		case NM_AIF: neurons.aif[chain]=(uint16_t)data; break;
+		case NM_MINIF: neurons.minif[chain]=(uint16_t)data; break;
+		case NM_CAT:
+			// writing the category commits the neuron
+			neurons.cat[chain]=(uint16_t)data;
+			if (chain >= neurons.count) neurons.count=chain + 1;
+			chain++;
+			index=0;
+			break;
+	}
+}
+// ---------------------------------------------------------
+// NeuroMemTransport interface
+// ---------------------------------------------------------
+int NeuroMemEmu::read(unsigned char mod, unsigned char reg)
+{
+	if (mod==mod_FPGA) return(reg==1 ? fpgaRev : 0);
+	if (mod!=mod_NM) return(0);
+	if (nsr & NSR_SR) return(readSR(reg));
+	return(readNormal(reg));
+}
+void NeuroMemEmu::write(unsigned char mod, unsigned char reg, int data)
+{
+	if (mod!=mod_NM) return;
+	if (nsr & NSR_SR) writeSR(reg, data);
+	else writeNormal(reg, data);
+}
+void NeuroMemEmu::writeAddr(long addr, int length, int data[])
+{
+	unsigned char mod=(unsigned char)((addr >> 24) & 0x7F);
+	unsigned char reg=(unsigned char)(addr & 0xFF);
+	for (int i=0; i<length; i++) write(mod, reg, data[i]);
+}
+void NeuroMemEmu::readAddr(long addr, int length, int data[])
+{
+	unsigned char mod=(unsigned char)((addr >> 24) & 0x7F);
+	unsigned char reg=(unsigned char)(addr & 0xFF);
+	for (int i=0; i<length; i++) data[i]=read(mod, reg);
+}
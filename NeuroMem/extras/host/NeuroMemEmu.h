@@ -0,0 +1,83 @@
+/************************************************************************/
+/*																		
+ *	NeuroMemEmu.h	--	Software model of a NeuroMem network
+ *
+ *  Register-accurate model of a chain of NeuroMem neurons (CM1K, NM500)
+ *  implementing the NeuroMemTransport interface, so the NeuroMemAI class
+ *  runs unchanged on a host computer:
+ *
+ *    NeuroMemEmu emu(576);
+ *    NeuroMemAI hNN;
+ *    hNN.begin(&emu);
+ *
+ *  Normal mode
+ *    COMP, LCOMP broadcast a vector; LCOMP triggers the distance evaluation
+ *    DIST, CAT, NID, AIF read the firing neurons by increasing distance
+ *    CAT written after a broadcast learns the vector (RCE rule)
+ *    NSR reports 0=unknown, 4=uncertain, 8=identified, plus the mode bits
+ *  Save and Restore mode (NSR bit 4)
+ *    RESETCHAIN points to the first neuron, NCR, COMP, AIF, MINIF and CAT
+ *    access the pointed neuron, reading or writing CAT moves to the next one
+ *
+ *  GCR[6:0] is the active context, 0 activates all the neurons, GCR[7] the norm
+ *  (0=L1, 1=LSup). Neurons with a context different from the active context
+ *  neither fire nor learn. CAT[15] is the degenerated flag, set when the
+ *  influence field of a neuron is clipped to its MINIF.
+ *  Firing neurons with the same distance are read by increasing category,
+ *  then by increasing identifier.
+ *
+ *  The neurons are kept in a NeuroMemStore and the distances are computed
+ *  with the SIMD kernels of NeuroMemKernels.h.
+ */
+/******************************************************************************/
+#ifndef _NeuroMemEmu_h_
+#define _NeuroMemEmu_h_
+
+#include "NeuroMemTransport.h"
+#include "NeuroMemStore.h"
+
+class NeuroMemEmu : public NeuroMemTransport
+{
+	public:
+
+		static const int NEURONSIZE=256; // memory capacity of each neuron in byte
+
+		NeuroMemEmu(int capacity=576);
+		~NeuroMemEmu();
+		void reset(); // power-on reset, neuron memory cleared
+
+		int read(unsigned char mod, unsigned char reg);
+		void write(unsigned char mod, unsigned char reg, int data);
+		void writeAddr(long addr, int length, int data[]);
+		void readAddr(long addr, int length, int data[]);
+
+		int capacity; // number of neurons in the chain
+		int fpgaRev=0; // value returned by the FPGA revision registers
+		NeuroMemStore neurons; // committed neurons first, then the ready-to-learn neuron
+
+	private:
+		// global registers
+		int gcr, minif, maxif, nsr, status;
+		int index; // component index
+		int vlen; // length of the last broadcast vector
+		unsigned char vector[NEURONSIZE];
+		int chain; // neuron pointed in Save and Restore mode
+
+		// results of the last broadcast
+		int* dist; // distance of the active neurons, -1 otherwise
+		int* firing; // heap of the firing neurons not read yet
+		int nfiring;
+		bool sorted; // firing is a heap in readout order
+		bool started; // readout started since the broadcast
+		int current; // neuron read out, -1 if none
+
+		void evaluate();
+		void learn(int category);
+		void forget();
+		int next();
+		int readNormal(unsigned char reg);
+		void writeNormal(unsigned char reg, int data);
+		int readSR(unsigned char reg);
+		void writeSR(unsigned char reg, int data);
+};
+#endif
@@ -0,0 +1,215 @@
+/************************************************************************/
+/*																		
+ *	NeuroMemKernels.cpp	--	Distance kernels of the NeuroMem host engines
+ *
+ *  L1:   sum of the absolute differences, psadbw on 16 or 32 bytes
+ *  LSup: maximum of the absolute differences, computed as the maximum
+ *        of the two saturated differences a-b and b-a
+ *  The limit is checked every 64 bytes
+ */
+/******************************************************************************/
+
+#include "NeuroMemKernels.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define NM_X86 1
+#include <immintrin.h>
+#endif
+
+static const int BLOCK=64; // bytes between two checks of the limit
+
+// ------------------------------------------------------------ 
+// Portable C
+// ------------------------------------------------------------ 
+static int L1Scalar(const uint8_t* a, const uint8_t* b, int length, int limit)
+{
+	int d=0;
+	for (int i=0; i<length; i+=BLOCK)
+	{
+		int end=(i + BLOCK < length) ? i + BLOCK : length;
+		for (int j=i; j<end; j++) d+=a[j] > b[j] ? a[j] - b[j] : b[j] - a[j];
+		if (d > limit) break;
+	}
+	return(d);
+}
+static int LSupScalar(const uint8_t* a, const uint8_t* b, int length, int limit)
+{
+	int d=0;
+	for (int i=0; i<length; i+=BLOCK)
+	{
+		int end=(i + BLOCK < length) ? i + BLOCK : length;
+		for (int j=i; j<end; j++)
+		{
+			int diff=a[j] > b[j] ? a[j] - b[j] : b[j] - a[j];
+			if (diff > d) d=diff;
+		}
+		if (d > limit) break;
+	}
+	return(d);
+}
+
+#ifdef NM_X86
+// ------------------------------------------------------------ 
+// SSE2
+// ------------------------------------------------------------ 
+static inline int hmaxSSE2(__m128i m)
+{
+	m=_mm_max_epu8(m, _mm_srli_si128(m, 8));
+	m=_mm_max_epu8(m, _mm_srli_si128(m, 4));
+	m=_mm_max_epu8(m, _mm_srli_si128(m, 2));
+	m=_mm_max_epu8(m, _mm_srli_si128(m, 1));
+	return(_mm_cvtsi128_si32(m) & 0xFF);
+}
+static int L1SSE2(const uint8_t* a, const uint8_t* b, int length, int limit)
+{
+	__m128i sum=_mm_setzero_si128();
+	int i=0;
+	while (i + 16 <= length)
+	{
+		int end=(i + BLOCK <= length) ? i + BLOCK : length & ~15;
+		for (; i<end; i+=16)
+		{
+			__m128i va=_mm_loadu_si128((const __m128i*)(a + i));
+			__m128i vb=_mm_loadu_si128((const __m128i*)(b + i));
+			sum=_mm_add_epi64(sum, _mm_sad_epu8(va, vb));
+		}
+		int d=_mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+		if (d > limit) return(d);
+	}
+	int d=_mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+	for (; i<length; i++) d+=a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+	return(d);
+}
+static int LSupSSE2(const uint8_t* a, const uint8_t* b, int length, int limit)
+{
+	__m128i m=_mm_setzero_si128();
+	int i=0;
+	while (i + 16 <= length)
+	{
+		int end=(i + BLOCK <= length) ? i + BLOCK : length & ~15;
+		for (; i<end; i+=16)
+		{
+			__m128i va=_mm_loadu_si128((const __m128i*)(a + i));
+			__m128i vb=_mm_loadu_si128((const __m128i*)(b + i));
+			m=_mm_max_epu8(m, _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va)));
+		}
+		if (limit < 255)
+		{
+			int d=hmaxSSE2(m);
+			if (d > limit) return(d);
+		}
+	}
+	int d=hmaxSSE2(m);
+	for (; i<length; i++)
+	{
+		int diff=a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+		if (diff > d) d=diff;
+	}
+	return(d);
+}
+
+// ------------------------------------------------------------ 
+// AVX2
+// ------------------------------------------------------------ 
+__attribute__((target("avx2")))
+static int L1AVX2(const uint8_t* a, const uint8_t* b, int length, int limit)
+{
+	__m256i sum=_mm256_setzero_si256();
+	int i=0;
+	while (i + 32 <= length)
+	{
+		int end=(i + BLOCK <= length) ? i + BLOCK : length & ~31;
+		for (; i<end; i+=32)
+		{
+			__m256i va=_mm256_loadu_si256((const __m256i*)(a + i));
+			__m256i vb=_mm256_loadu_si256((const __m256i*)(b + i));
+			sum=_mm256_add_epi64(sum, _mm256_sad_epu8(va, vb));
+		}
+		__m128i s=_mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+		int d=_mm_cvtsi128_si32(s) + _mm_cvtsi128_si32(_mm_srli_si128(s, 8));
+		if (d > limit) return(d);
+	}
+	__m128i s=_mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	int d=_mm_cvtsi128_si32(s) + _mm_cvtsi128_si32(_mm_srli_si128(s, 8));
+	for (; i<length; i++) d+=a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+	return(d);
+}
+__attribute__((target("avx2")))
+static int LSupAVX2(const uint8_t* a, const uint8_t* b, int length, int limit)
+{
+	__m256i m=_mm256_setzero_si256();
+	int i=0;
+	while (i + 32 <= length)
+	{
+		int end=(i + BLOCK <= length) ? i + BLOCK : length & ~31;
+		for (; i<end; i+=32)
+		{
+			__m256i va=_mm256_loadu_si256((const __m256i*)(a + i));
+			__m256i vb=_mm256_loadu_si256((const __m256i*)(b + i));
+			m=_mm256_max_epu8(m, _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va)));
+		}
+		if (limit < 255)
+		{
+			int d=hmaxSSE2(_mm_max_epu8(_mm256_castsi256_si128(m), _mm256_extracti128_si256(m, 1)));
+			if (d > limit) return(d);
+		}
+	}
+	int d=hmaxSSE2(_mm_max_epu8(_mm256_castsi256_si128(m), _mm256_extracti128_si256(m, 1)));
+	for (; i<length; i++)
+	{
+		int diff=a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+		if (diff > d) d=diff;
+	}
+	return(d);
+}
+#endif
+
+static const NeuroMemKernels kernels[3]=
+{
+	{ "scalar", L1Scalar, LSupScalar },
+#ifdef NM_X86
+	{ "sse2", L1SSE2, LSupSSE2 },
+	{ "avx2", L1AVX2, LSupAVX2 },
+#else
+	{ "scalar", L1Scalar, LSupScalar },
+	{ "scalar", L1Scalar, LSupScalar },
+#endif
+};
+
+// ------------------------------------------------------------ 
+// Runtime selection of the instruction set
+// ------------------------------------------------------------ 
+static int supportedLevel()
+{
+#ifdef NM_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return(NM_KERNEL_AVX2);
+	if (__builtin_cpu_supports("sse2")) return(NM_KERNEL_SSE2);
+#endif
+	return(NM_KERNEL_SCALAR);
+}
+const NeuroMemKernels& neuroMemKernels(int level)
+{
+	static const int supported=supportedLevel();
+	if (level > supported) level=supported;
+	if (level < NM_KERNEL_SCALAR) level=NM_KERNEL_SCALAR;
+	return(kernels[level]);
+}
+const NeuroMemKernels& neuroMemKernels()
+{
+	static const NeuroMemKernels& selected=[]() -> const NeuroMemKernels&
+	{
+		int level=NM_KERNEL_AVX2;
+		const char* env=getenv("NEUROMEM_KERNEL");
+		if (env!=0)
+		{
+			if (strcmp(env, "scalar")==0) level=NM_KERNEL_SCALAR;
+			else if (strcmp(env, "sse2")==0) level=NM_KERNEL_SSE2;
+		}
+		return(neuroMemKernels(level));
+	}();
+	return(selected);
+}
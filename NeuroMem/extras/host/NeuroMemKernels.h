@@ -0,0 +1,41 @@
+/************************************************************************/
+/*																		
+ *	NeuroMemKernels.h	--	Distance kernels of the NeuroMem host engines
+ *
+ *  L1 and LSup distances between two byte arrays, as computed by the
+ *  NeuroMem neurons. The best implementation for the CPU is selected
+ *  at runtime: AVX2, SSE2 or portable C.
+ *
+ *  The kernels compute the exact distance when it is lower or equal to
+ *  limit. Above limit, they may stop early and return any value greater
+ *  than limit. Use NM_NOLIMIT to always get the exact distance.
+ */
+/******************************************************************************/
+#ifndef _NeuroMemKernels_h_
+#define _NeuroMemKernels_h_
+
+#include <stdint.h>
+
+static const int NM_NOLIMIT=0x7FFFFFFF;
+
+typedef int (*NeuroMemDistance)(const uint8_t* vector, const uint8_t* model, int length, int limit);
+
+struct NeuroMemKernels
+{
+	const char* name;
+	NeuroMemDistance L1;
+	NeuroMemDistance LSup;
+};
+
+// Instruction sets of the kernels
+static const int NM_KERNEL_SCALAR=0;
+static const int NM_KERNEL_SSE2=1;
+static const int NM_KERNEL_AVX2=2;
+
+// Kernels selected for this CPU, can be forced with the environment
+// variable NEUROMEM_KERNEL=scalar, sse2 or avx2
+const NeuroMemKernels& neuroMemKernels();
+// Kernels of a given instruction set, or the best supported one below it
+const NeuroMemKernels& neuroMemKernels(int level);
+
+#endif
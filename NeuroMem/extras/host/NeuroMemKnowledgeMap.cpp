@@ -0,0 +1,134 @@
+/************************************************************************/
+/*																		
+ *	NeuroMemKnowledgeMap.cpp	--	Zero-copy access to a knowledge file
+ */
+/******************************************************************************/
+
+#include "NeuroMemKnowledgeMap.h"
+#include <NeuroMemKnowledge.h>
+
+#include <limits.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ------------------------------------------------------------ //
+//    Constructor to the class NeuroMemKnowledgeMap
+// ------------------------------------------------------------ 
+NeuroMemKnowledgeMap::NeuroMemKnowledgeMap()
+{
+}
+NeuroMemKnowledgeMap::~NeuroMemKnowledgeMap()
+{
+	close();
+}
+void NeuroMemKnowledgeMap::close()
+{
+	if (data!=0) munmap((void*)data, bytes);
+	data=0;
+	bytes=0;
+	count=0;
+	offsets.clear();
+}
+// ------------------------------------------------------------ 
+// Map a knowledge file and locate its neuron records
+// ------------------------------------------------------------ 
+int NeuroMemKnowledgeMap::open(const char* filename)
+{
+	close();
+	int fd=::open(filename, O_RDONLY);
+	if (fd < 0) return(2);
+	struct stat st;
+	if (fstat(fd, &st)!=0)
+	{
+		::close(fd);
+		return(3);
+	}
+	if (st.st_size < NeuroMemKnowledge::HEADER_SIZE)
+	{
+		::close(fd);
+		return(4);
+	}
+	void* p=mmap(0, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd); // the mapping keeps a reference to the file
+	if (p==MAP_FAILED) return(3);
+	data=(const uint8_t*)p;
+	bytes=(size_t)st.st_size;
+
+	long ncount=0;
+	if (NeuroMemKnowledge::unpackHeader(data, &neuronSize, &ncount, &flags)!=NeuroMemKnowledge::FORMAT_V2)
+	{
+		close();
+		return(4);
+	}
+	if ((neuronSize < 1) || (neuronSize > NEURONSIZE))
+	{
+		close();
+		return(4);
+	}
+	recHeader=NeuroMemKnowledge::recordHeaderSize(flags);
+	recSize=recHeader + neuronSize;
+	// the neuron count of the header must fit in the file, before any allocation
+	size_t minRecord=(flags & NeuroMemKnowledge::FLAG_USEDLEN) ? recHeader : recSize;
+	if ((bytes < (size_t)NeuroMemKnowledge::HEADER_SIZE + NeuroMemKnowledge::CHECKSUM_SIZE) || (ncount < 0)
+		|| ((size_t)ncount > (bytes - NeuroMemKnowledge::HEADER_SIZE - NeuroMemKnowledge::CHECKSUM_SIZE) / minRecord)
+		|| (ncount > INT_MAX))
+	{
+		close();
+		return(7);
+	}
+	size_t offset=NeuroMemKnowledge::HEADER_SIZE;
+	if (flags & NeuroMemKnowledge::FLAG_USEDLEN)
+	{
+		madvise((void*)data, bytes, MADV_SEQUENTIAL);
+		offsets.reserve(ncount);
+		for (long i=0; i<ncount; i++)
+		{
+			if (offset + recHeader > bytes) break;
+			offsets.push_back(offset);
+			int used=NeuroMemKnowledge::get16(data + offset + NeuroMemKnowledge::REGISTERS_SIZE);
+			offset+=recHeader + (used < neuronSize ? used : neuronSize);
+		}
+		madvise((void*)data, bytes, MADV_RANDOM);
+		if ((long)offsets.size()!=ncount)
+		{
+			close();
+			return(7);
+		}
+	}
+	else
+	{
+		offset+=(size_t)ncount * recSize;
+	}
+	if (offset + NeuroMemKnowledge::CHECKSUM_SIZE > bytes)
+	{
+		close();
+		return(7);
+	}
+	end=offset;
+	count=(int)ncount;
+	return(0);
+}
+// ------------------------------------------------------------ 
+// Number of components stored in a record, the next ones are null
+// ------------------------------------------------------------ 
+int NeuroMemKnowledgeMap::length(int n) const
+{
+	if (!(flags & NeuroMemKnowledge::FLAG_USEDLEN)) return(neuronSize);
+	int used=get16(record(n) + NeuroMemKnowledge::REGISTERS_SIZE);
+	return(used < neuronSize ? used : neuronSize);
+}
+bool NeuroMemKnowledgeMap::verify() const
+{
+	if (data==0) return(false);
+	uint32_t sum=0;
+	size_t offset=NeuroMemKnowledge::HEADER_SIZE;
+	while (offset < end)
+	{
+		int chunk=(end - offset > 0x4000) ? 0x4000 : (int)(end - offset);
+		sum=NeuroMemKnowledge::checksum(sum, data + offset, chunk);
+		offset+=chunk;
+	}
+	return(NeuroMemKnowledge::get32(data + end)==sum);
+}
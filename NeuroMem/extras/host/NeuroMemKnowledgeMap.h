@@ -0,0 +1,76 @@
+/************************************************************************/
+/*																		
+ *	NeuroMemKnowledgeMap.h	--	Zero-copy access to a knowledge file
+ *
+ *  Memory-maps a V2 knowledge file (see NeuroMemKnowledge.h) read-only
+ *  and exposes its neurons in place, with the same functions as a
+ *  NeuroMemStore, so neuroMemTopK and NeuroMemShardEngine classify
+ *  directly against the file:
+ *
+ *    NeuroMemKnowledgeMap knowledge;
+ *    if (knowledge.open("neurons.knf")==0)
+ *      neuroMemTopK(knowledge, 0, knowledge.size(), vector, length, gcr, false, K, hits);
+ *
+ *  Opening a file does not read the neurons: the pages are loaded by
+ *  the operating system when they are accessed, and are shared by all
+ *  the processes which map the same file.
+ *  Files with a fixed record size (saved with KN_usedLength=false) are
+ *  accessed with no index. With the used length of each neuron, open
+ *  builds an index of the records, reading only their headers.
+ */
+/******************************************************************************/
+#ifndef _NeuroMemKnowledgeMap_h_
+#define _NeuroMemKnowledgeMap_h_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+class NeuroMemKnowledgeMap
+{
+	public:
+
+		static const int NEURONSIZE=256; // largest neuron size of a file
+
+		NeuroMemKnowledgeMap();
+		~NeuroMemKnowledgeMap();
+
+		// Return 0, or the error codes of NeuroMemAI::loadKnowledge_SDcard
+		// 2=file not found, 3=cannot map the file, 4=not a V2 file or neurons
+		// larger than NEURONSIZE, 7=truncated file or neuron count above its size
+		int open(const char* filename);
+		void close();
+		bool verify() const; // compare the checksum of the records, reads the whole file
+
+		int neuronSize=0; // components per neuron in the file
+		int flags=0; // flags of the V2 header
+
+		// NeuroMemStore access, see NeuroMemSearch.h
+		int size() const { return(count); }
+		const uint8_t* model(int n) const { return(record(n) + recHeader); }
+		int length(int n) const;
+		int NCR(int n) const { return(get16(record(n))); }
+		int AIF(int n) const { return(get16(record(n) + 2)); }
+		int MINIF(int n) const { return(get16(record(n) + 4)); }
+		int CAT(int n) const { return(get16(record(n) + 6)); }
+
+	private:
+		const uint8_t* data=0;
+		size_t bytes=0;
+		int count=0;
+		int recHeader=0; // bytes before the components of a record
+		size_t recSize=0; // bytes of a record without FLAG_USEDLEN
+		std::vector<size_t> offsets; // records with FLAG_USEDLEN
+		size_t end=0; // offset of the checksum
+
+		const uint8_t* record(int n) const
+		{
+			return(data + (offsets.empty() ? 16 + (size_t)n * recSize : offsets[n]));
+		}
+		static int get16(const uint8_t* p) { return(p[0] | (p[1] << 8)); }
+
+		NeuroMemKnowledgeMap(const NeuroMemKnowledgeMap&);
+		NeuroMemKnowledgeMap& operator=(const NeuroMemKnowledgeMap&);
+};
+#endif
@@ -0,0 +1,69 @@
+/************************************************************************/
+/*																		
+ *	NeuroMemSPIDevice.cpp	--	NeuroMem network on the SPI bus of a host
+ */
+/******************************************************************************/
+
+#include "NeuroMemSPIDevice.h"
+
+NeuroMemSPIDevice::NeuroMemSPIDevice(NeuroMemTransport* network) : network(network)
+{
+	received=0;
+	word=0;
+	words=0;
+	length=0;
+	byteMicros=0;
+}
+void NeuroMemSPIDevice::clearCounters()
+{
+	transactions=0;
+	bytes=0;
+	busMicros=0;
+}
+// ---------------------------------------------------------
+// A transaction starts when the chip select goes low
+// ---------------------------------------------------------
+void NeuroMemSPIDevice::select(bool active)
+{
+	if (!active) return;
+	received=0;
+	words=0;
+	transactions++;
+	busMicros+=selectCost;
+	byteMicros=8000000.0 / SPI.clock + byteGap;
+}
+uint8_t NeuroMemSPIDevice::transfer(uint8_t data)
+{
+	bytes++;
+	busMicros+=byteMicros;
+	if (received < 8)
+	{
+		header[received++]=data;
+		if (received==8) length=((long)header[5] << 16) + (header[6] << 8) + header[7];
+		return(0);
+	}
+	if (words >= length) return(0);
+	unsigned char mod=header[1] & 0x7F;
+	unsigned char reg=header[4];
+	bool upper=((received - 8) & 1)==0;
+	received++;
+	if (header[1] & 0x80)
+	{
+		// Write_Addr: the register is written with the lower byte
+		if (upper) word=data << 8;
+		else
+		{
+			network->write(mod, reg, word + data);
+			words++;
+		}
+		return(0);
+	}
+	// Read_Addr: the register is read with the upper byte
+	if (upper)
+	{
+		word=network->read(mod, reg);
+		return((uint8_t)(word >> 8));
+	}
+	words++;
+	return((uint8_t)(word & 0xFF));
+}
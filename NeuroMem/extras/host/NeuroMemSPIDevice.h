@@ -0,0 +1,58 @@
+/************************************************************************/
+/*																		
+ *	NeuroMemSPIDevice.h	--	NeuroMem network on the SPI bus of a host
+ *
+ *  SPIDevice of the SPI.h shim which decodes the NeuroMem Smart protocol
+ *  and executes the register accesses on a NeuroMemTransport, usually a
+ *  NeuroMemEmu. The NeuroMemSPI driver then runs unchanged on a host:
+ *
+ *    NeuroMemEmu emu(576);
+ *    NeuroMemSPIDevice device(&emu);
+ *    SPI.attach(7, &device); // chip select of the NeuroShield
+ *    hNN.begin();
+ *
+ *  A transaction is a dummy byte, 4 address bytes (module with the write
+ *  flag in bit 7, 2 unused bytes, register), 3 length bytes, then length
+ *  words, most significant byte first, all to the same register.
+ *
+ *  The device also models the time of the bus, as spent by the board:
+ *  8 bits per byte at the clock of the SPISettings of the transaction,
+ *  plus a software gap per byte and a cost per chip select toggle
+ *  (digitalWrite and SPI.beginTransaction). The defaults estimate an
+ *  AVR at 16 MHz. The time of the neurons themselves is not modeled.
+ */
+/******************************************************************************/
+#ifndef _NeuroMemSPIDevice_h_
+#define _NeuroMemSPIDevice_h_
+
+#include "SPI.h"
+#include "NeuroMemTransport.h"
+
+class NeuroMemSPIDevice : public SPIDevice
+{
+	public:
+		NeuroMemSPIDevice(NeuroMemTransport* network);
+		void select(bool active);
+		uint8_t transfer(uint8_t data);
+
+		NeuroMemTransport* network;
+
+		// timing model
+		double byteGap=0.5; // us of software per byte
+		double selectCost=9.0; // us per transaction, chip select and SPI settings
+
+		// bus activity since the last clearCounters
+		unsigned long transactions=0;
+		unsigned long bytes=0;
+		double busMicros=0;
+		void clearCounters();
+
+	private:
+		uint8_t header[8];
+		int received; // bytes of the current transaction
+		int word; // word being written
+		int words; // words exchanged
+		int length;
+		double byteMicros; // us per byte at the clock of the transaction
+};
+#endif
@@ -0,0 +1,134 @@
+/************************************************************************/
+/*																		
+ *	NeuroMemSearch.h	--	K nearest firing neurons on a host
+ *
+ *  Same result as broadcasting a vector to a NeuroMem network and
+ *  reading K times DIST, CAT and NID, as NeuroMemAI::classify does
+ *  with K: the firing neurons sorted by increasing distance, then
+ *  category, then identifier.
+ *
+ *  The Store can be a NeuroMemStore or any class with the same
+ *  size, model, length, NCR, AIF and CAT functions, for example
+ *  NeuroMemKnowledgeMap. The components of a model after its
+ *  length are null.
+ */
+/******************************************************************************/
+#ifndef _NeuroMemSearch_h_
+#define _NeuroMemSearch_h_
+
+#include "NeuroMemKernels.h"
+
+#include <algorithm>
+
+struct NeuroMemHit
+{
+	int distance;
+	int category; // with the degenerated flag in bit 15
+	int nid; // identifier of the neuron, starting at 1
+};
+
+// Readout order of the firing neurons
+inline bool neuroMemBefore(const NeuroMemHit& a, const NeuroMemHit& b)
+{
+	if (a.distance!=b.distance) return(a.distance < b.distance);
+	if ((a.category & 0x7FFF)!=(b.category & 0x7FFF)) return((a.category & 0x7FFF) < (b.category & 0x7FFF));
+	return(a.nid < b.nid);
+}
+
+// --------------------------------------------------------
+// Broadcast a vector to the neurons [first, last) of a store
+// and update a heap of up to K firing neurons, the worst on top
+// k is the number of neurons in the heap, the new number is returned
+// Scanning consecutive ranges of neurons gives the same heap as
+// scanning their union
+// gcr: context [6:0] (0 activates all neurons)
+// knn: all the active neurons fire, otherwise if distance < AIF
+//---------------------------------------------------------
+template<class Store>
+int neuroMemScan(const Store& store, int first, int last, const uint8_t* vector, int length,
+	int gcr, bool knn, int K, NeuroMemHit heap[], int k)
+{
+	if (K <= 0) return(0);
+	const NeuroMemKernels& kernels=neuroMemKernels();
+	int context=gcr & 0x7F;
+	int bound=(k==K) ? heap[0].distance : NM_NOLIMIT; // distance of the K-th hit
+	if (length > 256) length=256; // memory capacity of a neuron
+	// distance of the components of the vector to null components:
+	// sum[j] and max[j] of the components j to length-1
+	int tailSum[257], tailMax[257];
+	bool tails=false;
+	for (int n=first; n<last; n++)
+	{
+		int ncr=store.NCR(n);
+		if ((context!=0) && ((ncr & 0x7F)!=context)) continue;
+		int limit=bound;
+		int aif=store.AIF(n);
+		if ((!knn) && (aif - 1 < limit)) limit=aif - 1;
+		if (limit < 0) continue;
+		int used=store.length(n);
+		int d;
+		if (used >= length)
+		{
+			d=(ncr & 0x80) ? kernels.LSup(vector, store.model(n), length, limit)
+				: kernels.L1(vector, store.model(n), length, limit);
+		}
+		else
+		{
+			if (!tails)
+			{
+				tailSum[length]=0;
+				tailMax[length]=0;
+				for (int j=length - 1; j>=0; j--)
+				{
+					tailSum[j]=tailSum[j + 1] + vector[j];
+					tailMax[j]=vector[j] > tailMax[j + 1] ? vector[j] : tailMax[j + 1];
+				}
+				tails=true;
+			}
+			if (ncr & 0x80)
+			{
+				d=tailMax[used];
+				if (d <= limit)
+				{
+					int head=kernels.LSup(vector, store.model(n), used, limit);
+					if (head > d) d=head;
+				}
+			}
+			else
+			{
+				d=tailSum[used];
+				if (d <= limit) d+=kernels.L1(vector, store.model(n), used, limit - d);
+			}
+		}
+		if (d > limit) continue;
+		NeuroMemHit hit={ d, store.CAT(n), n + 1 };
+		if (k < K)
+		{
+			heap[k++]=hit;
+			std::push_heap(heap, heap + k, neuroMemBefore);
+		}
+		else if (neuroMemBefore(hit, heap[0]))
+		{
+			std::pop_heap(heap, heap + k, neuroMemBefore);
+			heap[k - 1]=hit;
+			std::push_heap(heap, heap + k, neuroMemBefore);
+		}
+		else continue;
+		if (k==K) bound=heap[0].distance;
+	}
+	return(k);
+}
+// --------------------------------------------------------
+// Broadcast a vector to the neurons [first, last) of a store
+// and return up to K firing neurons in readout order
+// Return the number of hits, K or less
+//---------------------------------------------------------
+template<class Store>
+int neuroMemTopK(const Store& store, int first, int last, const uint8_t* vector, int length,
+	int gcr, bool knn, int K, NeuroMemHit hits[])
+{
+	int k=neuroMemScan(store, first, last, vector, length, gcr, knn, K, hits, 0);
+	std::sort_heap(hits, hits + k, neuroMemBefore);
+	return(k);
+}
+#endif
@@ -0,0 +1,223 @@
+/************************************************************************/
+/*																		
+ *	NeuroMemShardEngine.h	--	Multi-core classification on a host
+ *
+ *  The neurons of a store are split in one shard per thread. Each thread
+ *  computes the K first firing neurons of its shard (neuroMemTopK) for
+ *  all the vectors of a batch, block after block, and publishes each
+ *  block with an atomic counter. The calling thread also works on the
+ *  first shard, and merges a block as soon as all the shards are done
+ *  with it, while the other threads move on to the next blocks.
+ *  Within a block, the shard is scanned by tiles of neurons that fit in
+ *  the L2 cache, and each tile is compared to all the vectors of the block,
+ *  so the models are read from memory once per block instead of once per vector.
+ *  The merge is lock-free: each shard writes its own partial results.
+ *
+ *  The results are the same as neuroMemTopK on the whole store, which
+ *  is the same contract as NeuroMemAI::classify(vector, length, K, ...)
+ *
+ *    NeuroMemShardEngine<NeuroMemStore> engine(store, 8);
+ *    engine.classify(vectors, count, length, stride, gcr, knn, K, hits, nhits);
+ */
+/******************************************************************************/
+#ifndef _NeuroMemShardEngine_h_
+#define _NeuroMemShardEngine_h_
+
+#include "NeuroMemSearch.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+template<class Store>
+class NeuroMemShardEngine
+{
+	public:
+
+		static const int BLOCK=16; // vectors per block of the pipeline
+		static const int TILE=512; // neurons per tile, 128 KB of models
+
+		// threads=0 uses all the cores of the host
+		NeuroMemShardEngine(const Store& store, int threads=0);
+		~NeuroMemShardEngine();
+		int threads() const { return(nthreads); }
+
+		// --------------------------------------------------------
+		// Classify count vectors of length bytes, spaced by stride bytes
+		// hits[i*K .. i*K+nhits[i]-1] receives the firing neurons of vector i
+		// in readout order, see neuroMemTopK
+		//---------------------------------------------------------
+		void classify(const uint8_t* vectors, int count, int length, int stride,
+			int gcr, bool knn, int K, NeuroMemHit hits[], int nhits[]);
+
+	private:
+		const Store& store;
+		int nthreads;
+		std::vector<std::thread> pool;
+
+		// batch shared with the threads, written under the mutex before the
+		// generation changes, and copied by each thread under the mutex
+		struct Batch
+		{
+			const uint8_t* vectors=0;
+			int count=0, length=0, stride=0, gcr=0, K=0;
+			bool knn=false;
+			NeuroMemHit* partial=0; // [shard][vector][K]
+			int* npartial=0; // [shard][vector]
+			std::atomic<int>* done=0; // number of shards done per block
+			int nblocks=0;
+		};
+		std::mutex mutex;
+		std::condition_variable start, idle;
+		int generation=0;
+		int finished=0; // threads done with the current generation
+		bool stop=false;
+		Batch batch;
+		std::vector<NeuroMemHit> partial;
+		std::vector<int> npartial;
+		std::unique_ptr<std::atomic<int>[]> done;
+
+		void worker(int shard);
+		void search(int shard, int block, const Batch& b);
+		void merge(int block, const Batch& b, NeuroMemHit hits[], int nhits[]);
+};
+
+template<class Store>
+NeuroMemShardEngine<Store>::NeuroMemShardEngine(const Store& store, int threads) : store(store)
+{
+	if (threads <= 0) threads=(int)std::thread::hardware_concurrency();
+	if (threads <= 0) threads=1;
+	nthreads=threads;
+	finished=nthreads - 1;
+	for (int w=1; w<nthreads; w++) pool.push_back(std::thread(&NeuroMemShardEngine::worker, this, w));
+}
+template<class Store>
+NeuroMemShardEngine<Store>::~NeuroMemShardEngine()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop=true;
+	}
+	start.notify_all();
+	for (size_t w=0; w<pool.size(); w++) pool[w].join();
+}
+// --------------------------------------------------------
+// Search the neurons of a shard for the vectors of a block
+//---------------------------------------------------------
+template<class Store>
+void NeuroMemShardEngine<Store>::search(int shard, int block, const Batch& b)
+{
+	int n=store.size();
+	int first=(int)((long long)n * shard / nthreads);
+	int last=(int)((long long)n * (shard + 1) / nthreads);
+	int end=(block + 1) * BLOCK < b.count ? (block + 1) * BLOCK : b.count;
+	for (int i=block * BLOCK; i<end; i++) b.npartial[(size_t)shard * b.count + i]=0;
+	for (int tile=first; tile<last; tile+=TILE)
+	{
+		int tileEnd=tile + TILE < last ? tile + TILE : last;
+		for (int i=block * BLOCK; i<end; i++)
+		{
+			size_t slot=(size_t)shard * b.count + i;
+			b.npartial[slot]=neuroMemScan(store, tile, tileEnd, b.vectors + (size_t)i * b.stride, b.length, b.gcr, b.knn, b.K,
+				&b.partial[slot * b.K], b.npartial[slot]);
+		}
+	}
+	for (int i=block * BLOCK; i<end; i++)
+	{
+		size_t slot=(size_t)shard * b.count + i;
+		std::sort_heap(&b.partial[slot * b.K], &b.partial[slot * b.K] + b.npartial[slot], neuroMemBefore);
+	}
+	b.done[block].fetch_add(1, std::memory_order_release);
+}
+template<class Store>
+void NeuroMemShardEngine<Store>::worker(int shard)
+{
+	int seen=0;
+	while (1)
+	{
+		Batch b;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			start.wait(lock, [&]() { return(stop || (generation!=seen)); });
+			if (stop) return;
+			seen=generation;
+			b=batch;
+		}
+		for (int block=0; block<b.nblocks; block++) search(shard, block, b);
+		// the buffers of the batch are not reallocated before every thread is done
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			finished++;
+		}
+		idle.notify_one();
+	}
+}
+// --------------------------------------------------------
+// Merge the sorted partial results of the shards
+//---------------------------------------------------------
+template<class Store>
+void NeuroMemShardEngine<Store>::merge(int block, const Batch& b, NeuroMemHit hits[], int nhits[])
+{
+	std::vector<int> pos(nthreads);
+	int end=(block + 1) * BLOCK < b.count ? (block + 1) * BLOCK : b.count;
+	for (int i=block * BLOCK; i<end; i++)
+	{
+		for (int s=0; s<nthreads; s++) pos[s]=0;
+		int k=0;
+		while (k < b.K)
+		{
+			int best=-1;
+			for (int s=0; s<nthreads; s++)
+			{
+				size_t slot=(size_t)s * b.count + i;
+				if (pos[s] >= b.npartial[slot]) continue;
+				if ((best < 0) || neuroMemBefore(b.partial[slot * b.K + pos[s]], b.partial[((size_t)best * b.count + i) * b.K + pos[best]])) best=s;
+			}
+			if (best < 0) break;
+			hits[(size_t)i * b.K + k++]=b.partial[((size_t)best * b.count + i) * b.K + pos[best]++];
+		}
+		nhits[i]=k;
+	}
+}
+template<class Store>
+void NeuroMemShardEngine<Store>::classify(const uint8_t* vectors, int count, int length, int stride,
+	int gcr, bool knn, int K, NeuroMemHit hits[], int nhits[])
+{
+	if ((count <= 0) || (K <= 0)) return;
+	Batch b;
+	{
+		// wait for all the threads to be done with the previous batch
+		std::unique_lock<std::mutex> lock(mutex);
+		idle.wait(lock, [&]() { return(finished==nthreads - 1); });
+		finished=0;
+		partial.resize((size_t)nthreads * count * K);
+		npartial.resize((size_t)nthreads * count);
+		int nblocks=(count + BLOCK - 1) / BLOCK;
+		done.reset(new std::atomic<int>[nblocks]);
+		for (int block=0; block<nblocks; block++) done[block].store(0, std::memory_order_relaxed);
+		batch.vectors=vectors;
+		batch.count=count;
+		batch.length=length;
+		batch.stride=stride;
+		batch.gcr=gcr;
+		batch.knn=knn;
+		batch.K=K;
+		batch.partial=partial.data();
+		batch.npartial=npartial.data();
+		batch.done=done.get();
+		batch.nblocks=nblocks;
+		b=batch;
+		generation++;
+	}
+	start.notify_all();
+	for (int block=0; block<b.nblocks; block++)
+	{
+		search(0, block, b);
+		while (b.done[block].load(std::memory_order_acquire) < nthreads) std::this_thread::yield();
+		merge(block, b, hits, nhits);
+	}
+}
+#endif
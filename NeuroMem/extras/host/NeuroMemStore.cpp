@@ -0,0 +1,44 @@
+/************************************************************************/
+/*																		
+ *	NeuroMemStore.cpp	--	Neurons of the NeuroMem host engines
+ */
+/******************************************************************************/
+
+#include "NeuroMemStore.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const size_t ALIGNMENT=64;
+
+// ------------------------------------------------------------ //
+//    Constructor to the class NeuroMemStore
+// ------------------------------------------------------------ 
+NeuroMemStore::NeuroMemStore(int capacity) : capacity(capacity)
+{
+	void* p=0;
+	if (posix_memalign(&p, ALIGNMENT, (size_t)capacity * NEURONSIZE)!=0) p=0;
+	comps=(uint8_t*)p;
+	ncr=new uint8_t[capacity];
+	aif=new uint16_t[capacity];
+	minif=new uint16_t[capacity];
+	cat=new uint16_t[capacity];
+	clear();
+}
+NeuroMemStore::~NeuroMemStore()
+{
+	free(comps);
+	delete[] ncr;
+	delete[] aif;
+	delete[] minif;
+	delete[] cat;
+}
+void NeuroMemStore::clear()
+{
+	if (comps!=0) memset(comps, 0, (size_t)capacity * NEURONSIZE);
+	memset(ncr, 0, capacity);
+	memset(aif, 0, capacity * sizeof(uint16_t));
+	memset(minif, 0, capacity * sizeof(uint16_t));
+	memset(cat, 0, capacity * sizeof(uint16_t));
+	count=0;
+}
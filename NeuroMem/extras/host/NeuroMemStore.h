@@ -0,0 +1,48 @@
+/************************************************************************/
+/*																		
+ *	NeuroMemStore.h	--	Neurons of the NeuroMem host engines
+ *
+ *  Structure of arrays: the models are 64-byte aligned rows of
+ *  NEURONSIZE bytes, and each register of the neurons is a separate
+ *  array, so the distance kernels stream the models only.
+ */
+/******************************************************************************/
+#ifndef _NeuroMemStore_h_
+#define _NeuroMemStore_h_
+
+#include <stdint.h>
+#include <stddef.h>
+
+class NeuroMemStore
+{
+	public:
+
+		static const int NEURONSIZE=256; // memory capacity of each neuron in byte
+
+		NeuroMemStore(int capacity);
+		~NeuroMemStore();
+		void clear(); // clear the memory and the registers of all the neurons
+
+		int capacity; // number of neurons
+		int count=0; // number of committed neurons, stored first
+
+		uint8_t* comps; // capacity * NEURONSIZE, 64-byte aligned
+		uint8_t* ncr; // context [6:0] and norm [7]
+		uint16_t* aif;
+		uint16_t* minif;
+		uint16_t* cat; // category [14:0] and degenerated flag [15]
+
+		// access used by the search functions, see NeuroMemSearch.h
+		int size() const { return(count); }
+		const uint8_t* model(int n) const { return(comps + (size_t)n * NEURONSIZE); }
+		uint8_t* model(int n) { return(comps + (size_t)n * NEURONSIZE); }
+		int length(int) const { return(NEURONSIZE); } // components stored in the model
+		int NCR(int n) const { return(ncr[n]); }
+		int AIF(int n) const { return(aif[n]); }
+		int CAT(int n) const { return(cat[n]); }
+
+	private:
+		NeuroMemStore(const NeuroMemStore&);
+		NeuroMemStore& operator=(const NeuroMemStore&);
+};
+#endif
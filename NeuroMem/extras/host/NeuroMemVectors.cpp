@@ -0,0 +1,189 @@
+/************************************************************************/
+/*
+ *	NeuroMemVectors.cpp	--	Vectors of a file of the Knowledge Builder
+ */
+/******************************************************************************/
+
+#include "NeuroMemVectors.h"
+
+#include <algorithm>
+#include <thread>
+#include <stdio.h>
+
+// ------------------------------------------------------------
+// Vectors of a part of the file
+// ------------------------------------------------------------
+struct NeuroMemRows
+{
+	std::vector<int> context, category, length;
+	std::vector<int> first; // first value after the category, a component or the length
+	std::vector<bool> counted; // first is the number of values after it
+	std::vector<size_t> offset; // components after first
+	std::vector<long> line; // line of the row in the part
+	std::vector<uint8_t> comps;
+	long lines=0; // lines of the part
+	long error=0; // line of the part with an error, from 1, 0 if none
+	const char* message="";
+};
+
+// parse the lines of [begin, end), each ends with a line feed or at end
+static void parseRows(const char* begin, const char* end, NeuroMemRows* rows)
+{
+	const char* p=begin;
+	std::vector<long> values;
+	while (p < end)
+	{
+		const char* eol=p;
+		while ((eol < end) && (*eol!='\n')) eol++;
+		rows->lines++;
+		values.clear();
+		bool header=false, bad=false;
+		const char* q=p;
+		while (q < eol)
+		{
+			while ((q < eol) && ((*q==' ') || (*q=='\t') || (*q=='\r'))) q++;
+			if ((q==eol) || (*q==',')) { q++; continue; } // empty field, a trailing comma
+			if ((*q < '0') || (*q > '9'))
+			{
+				if ((*q=='-') || (*q=='+')) bad=true;
+				else header=true;
+				break;
+			}
+			long value=0;
+			while ((q < eol) && (*q >= '0') && (*q <= '9') && (value < 0x10000)) value=value * 10 + (*q++ - '0');
+			while ((q < eol) && ((*q==' ') || (*q=='\t') || (*q=='\r'))) q++;
+			if ((q < eol) && (*q!=',')) { bad=true; break; }
+			values.push_back(value);
+			q++;
+		}
+		p=eol + 1;
+		if ((header) && (values.empty())) continue; // column names
+		if ((header) || (bad) || ((values.size() > 0) && (values.size() < 5))
+			|| (values.size() > 5 + NeuroMemVectors::NEURONSIZE))
+		{
+			rows->error=rows->lines;
+			rows->message=header || bad ? "not a list of positive integers" : "not 1 to 256 components";
+			return;
+		}
+		if (values.empty()) continue;
+		if ((values[2] > 0xFF) || (values[3] > 0x7FFF))
+		{
+			rows->error=rows->lines;
+			rows->message="context above 255 or category above 32767";
+			return;
+		}
+		rows->context.push_back((int)values[2]);
+		rows->category.push_back((int)values[3]);
+		rows->first.push_back((int)values[4]);
+		rows->counted.push_back(values[4]==(long)values.size() - 5);
+		rows->offset.push_back(rows->comps.size());
+		rows->line.push_back(rows->lines);
+		rows->length.push_back((int)values.size() - 5);
+		for (size_t i=5; i<values.size(); i++)
+		{
+			if (values[i] > 0xFF)
+			{
+				rows->error=rows->lines;
+				rows->message="component above 255";
+				return;
+			}
+			rows->comps.push_back((uint8_t)values[i]);
+		}
+	}
+}
+
+// ------------------------------------------------------------
+// Read the file, parse one part per thread, then gather the
+// vectors in the order of the file
+// ------------------------------------------------------------
+int NeuroMemVectors::read(const char* filename, int threads)
+{
+	context.clear(); category.clear(); length.clear(); comps.clear();
+	line=0;
+	message="";
+	if (threads <= 0) threads=(int)std::thread::hardware_concurrency();
+	if (threads <= 0) threads=1;
+	this->threads=threads;
+
+	FILE* f=fopen(filename, "rb");
+	if (f==0)
+	{
+		message="cannot open the file";
+		return(2);
+	}
+	std::vector<char> text;
+	char chunk[65536];
+	size_t n;
+	while ((n=fread(chunk, 1, sizeof(chunk), f)) > 0) text.insert(text.end(), chunk, chunk + n);
+	fclose(f);
+	const char* data=text.data();
+	bytes=text.size();
+	std::vector<size_t> cuts(1, 0);
+	for (int t=1; t<threads; t++)
+	{
+		size_t cut=std::max(cuts.back(), bytes * t / threads);
+		while ((cut < bytes) && (cut > 0) && (data[cut - 1]!='\n')) cut++;
+		cuts.push_back(cut);
+	}
+	cuts.push_back(bytes);
+	std::vector<NeuroMemRows> parts(threads);
+	std::vector<std::thread> pool;
+	for (int t=0; t<threads; t++) pool.push_back(std::thread(parseRows, data + cuts[t], data + cuts[t + 1], &parts[t]));
+	for (size_t t=0; t<pool.size(); t++) pool[t].join();
+
+	size_t count=0;
+	counted=true;
+	for (int t=0; t<threads; t++)
+	{
+		if (parts[t].error!=0)
+		{
+			line+=parts[t].error;
+			message=parts[t].message;
+			return(4);
+		}
+		line+=parts[t].lines;
+		count+=parts[t].context.size();
+		for (size_t i=0; i<parts[t].counted.size(); i++) counted=counted && parts[t].counted[i];
+	}
+	line=0;
+	if (count==0) counted=false;
+
+	comps.assign(count * NEURONSIZE, 0);
+	size_t v=0;
+	long rowLine=0; // lines of the parts before
+	for (int t=0; t<threads; t++)
+	{
+		NeuroMemRows &rows=parts[t];
+		for (size_t i=0; i<rows.context.size(); i++, v++)
+		{
+			uint8_t* vector=&comps[v * NEURONSIZE];
+			int used=0;
+			if ((!counted) && (rows.first[i] > 0xFF))
+			{
+				line=rowLine + rows.line[i];
+				message="component above 255";
+				return(4);
+			}
+			// with or without the length column
+			if ((counted ? 0 : 1) + rows.length[i] > NEURONSIZE)
+			{
+				line=rowLine + rows.line[i];
+				message="more than 256 components";
+				return(4);
+			}
+			if (!counted) vector[used++]=(uint8_t)rows.first[i];
+			for (int j=0; j<rows.length[i]; j++) vector[used++]=rows.comps[rows.offset[i] + j];
+			if (used==0)
+			{
+				line=rowLine + rows.line[i];
+				message="no component";
+				return(4);
+			}
+			context.push_back(rows.context[i]);
+			category.push_back(rows.category[i]);
+			length.push_back(used);
+		}
+		rowLine+=rows.lines;
+	}
+	return(0);
+}
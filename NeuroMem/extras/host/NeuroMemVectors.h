@@ -0,0 +1,49 @@
+/************************************************************************/
+/*
+ *	NeuroMemVectors.h	--	Vectors of a file of the Knowledge Builder
+ *
+ *  Reads a file of vectors in the CSV format of the NeuroMem Knowledge
+ *  Builder, as written by log2csv from the log of the examples:
+ *
+ *    patternID, parentID, Context, GTcategory, v1, v2, ...
+ *
+ *  The rows of log2csv have the vector length before the components,
+ *  it is detected when every row has it. The lines which do not start with
+ *  a number are column names. The file is parsed by several threads, one
+ *  part of the file each, cut at line feeds:
+ *
+ *    NeuroMemVectors vectors;
+ *    if (vectors.read("vectors.txt")==0)
+ *      neuroMemTopK(store, 0, store.size(), vectors.vector(0), vectors.length[0], vectors.context[0], false, K, hits);
+ */
+/******************************************************************************/
+#ifndef _NeuroMemVectors_h_
+#define _NeuroMemVectors_h_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+class NeuroMemVectors
+{
+	public:
+
+		static const int NEURONSIZE=256; // memory capacity of each neuron in byte
+
+		// Return 0, 2 if the file cannot be read, 4 if a line is not a
+		// vector, see line and message. threads=0 uses all the cores
+		int read(const char* filename, int threads=0);
+
+		size_t size() const { return(category.size()); }
+		const uint8_t* vector(size_t i) const { return(&comps[i * NEURONSIZE]); }
+
+		std::vector<int> context, category, length;
+		std::vector<uint8_t> comps; // NEURONSIZE per vector, null after its length
+		bool counted=false; // the 5th column was the vector length
+		size_t bytes=0; // size of the file
+		int threads=0; // threads of the last read
+		long line=0; // line of the error, from 1
+		std::string message;
+};
+#endif
@@ -0,0 +1,62 @@
+/************************************************************************/
+/*																		
+ *	SD.h	--	Minimal Arduino SD library for a host computer
+ *
+ *  The files are opened in the current directory of the process,
+ *  or in the directory passed to SD.begin(chipSelect, root).
+ *  FILE_WRITE keeps the O_APPEND behavior of the Arduino library:
+ *  every write is appended at the end of the file.
+ */
+/******************************************************************************/
+#ifndef _SDHost_h_
+#define _SDHost_h_
+
+#include "Arduino.h"
+
+#define O_READ 0x01
+#define O_WRITE 0x02
+#define O_RDWR (O_READ | O_WRITE)
+#define O_APPEND 0x04
+#define O_CREAT 0x10
+#define O_TRUNC 0x40
+
+#define FILE_READ O_READ
+#define FILE_WRITE (O_READ | O_WRITE | O_CREAT | O_APPEND)
+
+class File
+{
+	public:
+		File() {}
+		File(FILE* f, uint8_t mode) : f(f), mode(mode) {}
+		size_t write(uint8_t b);
+		size_t write(const uint8_t* buf, size_t size);
+		int read();
+		int read(void* buf, uint16_t nbyte);
+		int peek();
+		int available();
+		void flush();
+		bool seek(uint32_t pos);
+		uint32_t position();
+		uint32_t size();
+		void close();
+		operator bool() { return f!=0; }
+	private:
+		FILE* f=0;
+		uint8_t mode=0;
+};
+
+class SDClass
+{
+	public:
+		bool begin(uint8_t csPin=0, const char* root=0);
+		File open(const char* filename, uint8_t mode=FILE_READ);
+		bool exists(const char* filename);
+		bool remove(const char* filename);
+	private:
+		char root[256]="";
+		void path(const char* filename, char* out, size_t len);
+};
+
+extern SDClass SD;
+
+#endif
@@ -0,0 +1,63 @@
+/************************************************************************/
+/*																		
+ *	SPI.h	--	Minimal Arduino SPI library for a host computer
+ *
+ *  There is no SPI bus on a host. The bytes are exchanged with an
+ *  optional SPIDevice attached to the SPI object, which is selected
+ *  by its chip select pin. Without device, transfer returns 0.
+ */
+/******************************************************************************/
+#ifndef _SPIHost_h_
+#define _SPIHost_h_
+
+#include "Arduino.h"
+
+#define MSBFIRST 1
+#define LSBFIRST 0
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+class SPISettings
+{
+	public:
+		SPISettings(uint32_t clock=4000000, uint8_t bitOrder=MSBFIRST, uint8_t dataMode=SPI_MODE0)
+			: clock(clock), bitOrder(bitOrder), dataMode(dataMode) {}
+		uint32_t clock;
+		uint8_t bitOrder;
+		uint8_t dataMode;
+};
+
+// Peripheral emulated on the host side of the SPI bus
+class SPIDevice
+{
+	public:
+		virtual void select(bool active)=0; // chip select low (true) or high (false)
+		virtual uint8_t transfer(uint8_t data)=0;
+};
+
+class SPIClass
+{
+	public:
+		void begin() {}
+		void end() {}
+		void beginTransaction(SPISettings settings) { clock=settings.clock; }
+		void endTransaction() {}
+		uint8_t transfer(uint8_t data);
+		void transfer(void* buf, size_t count);
+		// Host only: attach an emulated peripheral to a chip select pin, 0 to detach it
+		void attach(uint8_t pin, SPIDevice* device);
+		void chipSelect(uint8_t pin, uint8_t val);
+		uint32_t clock=4000000;
+	private:
+		static const int MAX_DEVICES=8;
+		uint8_t pins[MAX_DEVICES];
+		SPIDevice* devices[MAX_DEVICES];
+		int ndevices=0;
+		SPIDevice* selected=0;
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,225 @@
+/************************************************************************/
+/*
+ *	bench_async.cpp	--	Split-phase classification on an asynchronous transport
+ *
+ *  AsyncTransport completes the Write_Addr of NeuroMemAI::beginClassify in
+ *  the background, as a DMA or interrupt-driven SPI driver would, with the
+ *  bus time of the NeuroShield (2 MHz) or of the clock given on the command
+ *  line. The other transactions are synchronous and wait for the end of
+ *  the transfer in progress.
+ *
+ *  The frames of a camera are captured (modeled CPU time), subsampled to
+ *  11x11 blocks and classified, first with classify, then with the capture
+ *  of the next frame overlapped with the transfer of the previous vector:
+ *
+ *    beginClassify(vector[i])
+ *    capture and subsample frame i+1
+ *    finishClassify(&dist, &cat, &nid)
+ *
+ *  The responses must be identical (exit status 1 otherwise), and the time
+ *  per frame of both loops is reported.
+ *
+ *  bench_async [frames=200] [captureUs=1000] [clockHz=2000000]
+ *
+ *  From the NeuroMem folder:
+ *  g++ -O2 -std=c++11 -Iextras/host -I. extras/host/bench_async.cpp NeuroMemAI.cpp NeuroMemSPI.cpp \
+ *      NeuroMemTrace.cpp NeuroMemKnowledge.cpp extras/host/NeuroMemEmu.cpp extras/host/NeuroMemStore.cpp \
+ *      extras/host/NeuroMemKernels.cpp extras/host/ArduinoHost.cpp -o bench_async
+ */
+/******************************************************************************/
+
+#include <NeuroMemAI.h>
+#include "NeuroMemEmu.h"
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static const int SIDE=121; // region of interest of the example, in pixels
+static const int BLOCK=11; // subsampling block
+static const int LENGTH=(SIDE / BLOCK) * (SIDE / BLOCK);
+static const int PATTERNS=10;
+
+// busy wait, more accurate than a sleep for some microseconds
+static void spin(double us)
+{
+	Clock::time_point end=Clock::now() + std::chrono::nanoseconds((long long)(us * 1000));
+	while (Clock::now() < end);
+}
+
+// ------------------------------------------------------------
+// Transport of an emulated network with the bus time of a board:
+// 8 bits per byte at the clock, 0.5 us per byte and 9 us per
+// transaction (see NeuroMemSPIDevice). startWriteAddr returns at once,
+// and the transfer completes when its bus time has elapsed: the data
+// is read at that time, as by a DMA controller
+// ------------------------------------------------------------
+class AsyncTransport : public NeuroMemTransport
+{
+	public:
+
+		AsyncTransport(NeuroMemEmu* emu, long clock) : emu(emu), usPerByte(8e6 / clock + 0.5) {}
+
+		int read(unsigned char mod, unsigned char reg)
+		{
+			finish();
+			spin(transactionUs(1));
+			return(emu->read(mod, reg));
+		}
+		void write(unsigned char mod, unsigned char reg, int data)
+		{
+			finish();
+			spin(transactionUs(1));
+			emu->write(mod, reg, data);
+		}
+		void writeAddr(long addr, int length, int data[])
+		{
+			finish();
+			spin(transactionUs(length));
+			emu->writeAddr(addr, length, data);
+		}
+		void readAddr(long addr, int length, int data[])
+		{
+			finish();
+			spin(transactionUs(length));
+			emu->readAddr(addr, length, data);
+		}
+		void startWriteAddr(long addr, int length, int data[])
+		{
+			finish();
+			pendingAddr=addr;
+			pendingLength=length;
+			pendingData=data; // not copied
+			end=Clock::now() + std::chrono::nanoseconds((long long)(transactionUs(length) * 1000));
+		}
+		bool done()
+		{
+			if (pendingData==0) return(true);
+			if (Clock::now() < end) return(false);
+			emu->writeAddr(pendingAddr, pendingLength, pendingData);
+			pendingData=0;
+			return(true);
+		}
+
+	private:
+
+		NeuroMemEmu* emu;
+		double usPerByte;
+		long pendingAddr=0;
+		int pendingLength=0;
+		int* pendingData=0; // transfer in progress
+		Clock::time_point end;
+
+		// dummy byte, module, 2 bytes, register, 3 length bytes, then the words
+		double transactionUs(int words)
+		{
+			return(9 + (8 + 2.0 * words) * usPerByte);
+		}
+		void finish()
+		{
+			while (!done());
+		}
+};
+
+// ------------------------------------------------------------
+// Frame of the camera: one of the patterns plus noise
+// ------------------------------------------------------------
+static void capture(const std::vector<uint8_t> &patterns, int index, std::mt19937 &rng,
+	double captureUs, uint8_t frame[])
+{
+	Clock::time_point start=Clock::now();
+	const uint8_t* pattern=&patterns[(size_t)(index % PATTERNS) * SIDE * SIDE];
+	for (int i=0; i<SIDE * SIDE; i++)
+	{
+		int v=pattern[i] + (int)(rng() % 9) - 4;
+		frame[i]=(uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+	}
+	double elapsed=std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+	if (elapsed < captureUs) spin(captureUs - elapsed);
+}
+static void subsample(const uint8_t frame[], int vector[])
+{
+	int n=0;
+	for (int by=0; by<SIDE; by+=BLOCK)
+	{
+		for (int bx=0; bx<SIDE; bx+=BLOCK)
+		{
+			int sum=0;
+			for (int y=by; y<by + BLOCK; y++)
+				for (int x=bx; x<bx + BLOCK; x++) sum+=frame[y * SIDE + x];
+			vector[n++]=sum / (BLOCK * BLOCK);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int frames=argc > 1 ? atoi(argv[1]) : 200;
+	double captureUs=argc > 2 ? atof(argv[2]) : 1000;
+	long clock=argc > 3 ? atol(argv[3]) : 2000000;
+
+	std::mt19937 rng(1);
+	std::vector<uint8_t> patterns((size_t)PATTERNS * SIDE * SIDE);
+	for (size_t i=0; i<patterns.size(); i++) patterns[i]=(uint8_t)(rng() & 0xFF);
+
+	NeuroMemEmu emu(576);
+	AsyncTransport transport(&emu, clock);
+	NeuroMemAI hNN;
+	if (hNN.begin(&transport)!=0) return(1);
+
+	// learn each pattern once
+	std::vector<uint8_t> frame(SIDE * SIDE);
+	int vector[LENGTH];
+	for (int p=0; p<PATTERNS; p++)
+	{
+		capture(patterns, p, rng, 0, frame.data());
+		subsample(frame.data(), vector);
+		hNN.learn(vector, LENGTH, p + 1);
+	}
+
+	// sequential: capture, then classify
+	std::vector<int> expected((size_t)frames * 3), responses((size_t)frames * 3);
+	std::mt19937 noise(2);
+	Clock::time_point start=Clock::now();
+	for (int f=0; f<frames; f++)
+	{
+		capture(patterns, f, noise, captureUs, frame.data());
+		subsample(frame.data(), vector);
+		hNN.classify(vector, LENGTH, &expected[f * 3], &expected[f * 3 + 1], &expected[f * 3 + 2]);
+	}
+	double sequential=std::chrono::duration<double, std::micro>(Clock::now() - start).count() / frames;
+
+	// overlapped: capture the next frame while the vector is sent
+	noise.seed(2);
+	int vectors[2][LENGTH];
+	start=Clock::now();
+	capture(patterns, 0, noise, captureUs, frame.data());
+	subsample(frame.data(), vectors[0]);
+	for (int f=0; f<frames; f++)
+	{
+		hNN.beginClassify(vectors[f & 1], LENGTH);
+		if (f + 1 < frames)
+		{
+			capture(patterns, f + 1, noise, captureUs, frame.data());
+			subsample(frame.data(), vectors[(f + 1) & 1]);
+		}
+		hNN.finishClassify(&responses[f * 3], &responses[f * 3 + 1], &responses[f * 3 + 2]);
+	}
+	double overlapped=std::chrono::duration<double, std::micro>(Clock::now() - start).count() / frames;
+
+	int errors=0;
+	for (int f=0; f<frames; f++)
+	{
+		if ((responses[f * 3]!=expected[f * 3]) || (responses[f * 3 + 1]!=expected[f * 3 + 1])
+			|| (responses[f * 3 + 2]!=expected[f * 3 + 2])) errors++;
+	}
+	printf("frames %d, %d components, capture %.0f us, clock %ld Hz\n", frames, LENGTH, captureUs, clock);
+	printf("classify                     %.0f us per frame\n", sequential);
+	printf("beginClassify/finishClassify %.0f us per frame\n", overlapped);
+	printf("responses differing: %d\n", errors);
+	return(errors==0 ? 0 : 1);
+}
@@ -0,0 +1,102 @@
+/************************************************************************/
+/*
+ *	bench_batch.cpp	--	learnBatch and classifyBatch against one call per vector
+ *
+ *  A NeuroShield (NeuroMemSPIDevice, 576 neurons) learns a training set of
+ *  20 vectors of 40 categories, as replayed from a vectors.txt file, with
+ *  learn then with learnBatch, and classifies 400 test vectors with classify,
+ *  then with classifyBatch with and without the status. Report the
+ *  transactions and the modeled bus time per vector for vector lengths of
+ *  16, 64 and 256. The neurons and the responses must be the same with and
+ *  without the batches (exit status 1 otherwise).
+ *
+ *  From the NeuroMem folder:
+ *  g++ -O2 -std=c++11 -Iextras/host -I. extras/host/bench_batch.cpp NeuroMemAI.cpp NeuroMemSPI.cpp \
+ *      NeuroMemTrace.cpp NeuroMemKnowledge.cpp extras/host/NeuroMemSPIDevice.cpp extras/host/NeuroMemEmu.cpp \
+ *      extras/host/NeuroMemStore.cpp extras/host/NeuroMemKernels.cpp extras/host/ArduinoHost.cpp -o bench_batch
+ */
+/******************************************************************************/
+
+#include <NeuroMemAI.h>
+#include "NeuroMemEmu.h"
+#include "NeuroMemSPIDevice.h"
+
+#include <random>
+#include <vector>
+#include <stdio.h>
+
+static const int CATEGORIES=40, SAMPLES=20, TESTS=400, CAPACITY=576;
+static const int NEURONDATA=NeuroMemAI::NEURONSIZE + 4;
+
+static void dataset(int length, int count, unsigned seed, std::vector<int> &vectors, std::vector<int> &categories)
+{
+	std::mt19937 prototypes(1), rng(seed);
+	std::vector<int> centers((size_t)CATEGORIES * length);
+	for (size_t i=0; i<centers.size(); i++) centers[i]=(int)(prototypes() & 0xFF);
+	vectors.resize((size_t)count * length);
+	categories.resize(count);
+	for (int v=0; v<count; v++)
+	{
+		categories[v]=1 + v % CATEGORIES;
+		for (int j=0; j<length; j++)
+		{
+			int c=centers[(size_t)(categories[v] - 1) * length + j] + (int)(rng() % 61) - 30;
+			vectors[(size_t)v * length + j]=c < 0 ? 0 : (c > 255 ? 255 : c);
+		}
+	}
+}
+
+int main()
+{
+	static const int lengths[3]={ 16, 64, 256 };
+	int errors=0;
+	printf("length,operation,transactions_per_vector,us_per_vector\n");
+	for (int l=0; l<3; l++)
+	{
+		int length=lengths[l];
+		std::vector<int> train, trainCats, test, testCats;
+		dataset(length, CATEGORIES * SAMPLES, 2, train, trainCats);
+		dataset(length, TESTS, 3, test, testCats);
+
+		NeuroMemEmu emu(CAPACITY);
+		NeuroMemSPIDevice device(&emu);
+		SPI.attach(7, &device);
+		NeuroMemAI hNN;
+		if (hNN.begin()!=0) { fprintf(stderr, "NeuroShield not found\n"); return(1); }
+		hNN.setContext(1, 2, 0x4000);
+		int n=CATEGORIES * SAMPLES;
+
+		// one call per vector
+		device.clearCounters();
+		for (int v=0; v<n; v++) hNN.learn(&train[(size_t)v * length], length, trainCats[v]);
+		printf("%d,learn,%.1f,%.0f\n", length, (double)device.transactions / n, device.busMicros / n);
+		std::vector<int> neurons((size_t)CAPACITY * NEURONDATA), batchNeurons((size_t)CAPACITY * NEURONDATA);
+		int ncount=hNN.readNeurons(neurons.data());
+		std::vector<int> d(TESTS), c(TESTS), id(TESTS), s(TESTS);
+		device.clearCounters();
+		for (int t=0; t<TESTS; t++) s[t]=hNN.classify(&test[(size_t)t * length], length, &d[t], &c[t], &id[t]);
+		printf("%d,classify,%.1f,%.0f\n", length, (double)device.transactions / TESTS, device.busMicros / TESTS);
+
+		// batches
+		hNN.forget();
+		hNN.setContext(1, 2, 0x4000);
+		device.clearCounters();
+		int batchCount=hNN.learnBatch(train.data(), n, length, trainCats.data());
+		printf("%d,learnBatch,%.1f,%.0f\n", length, (double)device.transactions / n, device.busMicros / n);
+		if ((batchCount!=ncount) || (hNN.readNeurons(batchNeurons.data())!=ncount)
+			|| (neurons!=batchNeurons)) errors++;
+		std::vector<int> bd(TESTS), bc(TESTS), bid(TESTS), bs(TESTS);
+		device.clearCounters();
+		hNN.classifyBatch(test.data(), TESTS, length, bd.data(), bc.data(), bid.data(), bs.data());
+		printf("%d,classifyBatch,%.1f,%.0f\n", length, (double)device.transactions / TESTS, device.busMicros / TESTS);
+		if ((bd!=d) || (bc!=c) || (bid!=id) || (bs!=s)) errors++;
+		device.clearCounters();
+		hNN.classifyBatch(test.data(), TESTS, length, bd.data(), bc.data(), bid.data());
+		printf("%d,classifyBatch without status,%.1f,%.0f\n", length, (double)device.transactions / TESTS,
+			device.busMicros / TESTS);
+		if ((bd!=d) || (bc!=c) || (bid!=id)) errors++;
+		SPI.attach(7, 0);
+	}
+	if (errors!=0) fprintf(stderr, "%d batches differ from one call per vector\n", errors);
+	return(errors==0 ? 0 : 1);
+}
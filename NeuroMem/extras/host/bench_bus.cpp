@@ -0,0 +1,147 @@
+/************************************************************************/
+/*																		
+ *	bench_bus.cpp	--	Bus time of the NeuroMemAI functions without hardware
+ *
+ *  Drive NeuroMemAI through NeuroMemSPI and the SPI.h shim to an emulated
+ *  network (NeuroMemSPIDevice), and report the modeled bus time of learn,
+ *  classify, classify K, readNeurons, writeNeurons, saveKnowledge_SDcard and
+ *  loadKnowledge_SDcard, for each platform clock (NeuroShield 2 MHz,
+ *  BrainCard and NeuroTile 4 MHz), with and without the burst transfers,
+ *  for vector lengths of 16 to 256 and up to 4096 neurons.
+ *  The time of the SD card is not included.
+ *  Output in CSV format, or one JSON object per line:
+ *  platform,clock_hz,burst,length,neurons,operation,calls,transactions,bytes,us_per_call
+ *
+ *  bench_bus [csv|json] [maxNeurons=4096]
+ *
+ *  From the NeuroMem folder:
+ *  g++ -O2 -std=c++11 -Iextras/host -I. extras/host/bench_bus.cpp NeuroMemAI.cpp NeuroMemSPI.cpp NeuroMemTrace.cpp \
+ *      NeuroMemKnowledge.cpp extras/host/NeuroMemSPIDevice.cpp extras/host/NeuroMemEmu.cpp \
+ *      extras/host/NeuroMemStore.cpp extras/host/NeuroMemKernels.cpp extras/host/ArduinoHost.cpp -o bench_bus
+ */
+/******************************************************************************/
+
+#include <NeuroMemAI.h>
+#include "NeuroMemEmu.h"
+#include "NeuroMemSPIDevice.h"
+#include "SD.h"
+
+#include <random>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const int NEURONDATA=NeuroMemAI::NEURONSIZE + 4;
+static const int CALLS=32; // calls of learn and classify per configuration
+
+struct Platform
+{
+	const char* name;
+	int id; // HW_ value of NeuroMemSPI
+	int pin; // chip select
+	int fpgaRev; // tells the BrainCard from the NeuroTile
+	long clock;
+};
+static const Platform platforms[3]={
+	{ "NeuroShield", 2, 7, 0, 2000000 },
+	{ "BrainCard", 1, 10, 0x21, 4000000 },
+	{ "NeuroTile", 3, 10, 0, 4000000 } };
+
+static bool json=false;
+
+static void report(const Platform &p, bool burst, int length, int neurons, const char* operation,
+	int calls, NeuroMemSPIDevice &device)
+{
+	double perCall=device.busMicros / calls;
+	if (json)
+	{
+		printf("{\"platform\":\"%s\",\"clock_hz\":%ld,\"burst\":%d,\"length\":%d,\"neurons\":%d,"
+			"\"operation\":\"%s\",\"calls\":%d,\"transactions\":%lu,\"bytes\":%lu,\"us_per_call\":%.1f}\n",
+			p.name, p.clock, burst ? 1 : 0, length, neurons, operation, calls,
+			device.transactions, device.bytes, perCall);
+	}
+	else
+	{
+		printf("%s,%ld,%d,%d,%d,%s,%d,%lu,%lu,%.1f\n", p.name, p.clock, burst ? 1 : 0, length, neurons,
+			operation, calls, device.transactions, device.bytes, perCall);
+	}
+	device.clearCounters();
+}
+
+static void bench(const Platform &p, bool burst, int length, int neurons)
+{
+	std::mt19937 rng(length * 7919 + neurons);
+	NeuroMemEmu emu(neurons + CALLS);
+	emu.fpgaRev=p.fpgaRev;
+	NeuroMemSPIDevice device(&emu);
+	SPI.attach(p.pin, &device);
+	NeuroMemAI hNN;
+	hNN.burst=burst;
+	if ((hNN.begin()!=0) || (hNN.spi.platform!=p.id))
+	{
+		fprintf(stderr, "%s not detected\n", p.name);
+		exit(1);
+	}
+	device.clearCounters();
+
+	// neurons of 10 categories with overlapping influence fields
+	std::vector<int> data((size_t)neurons * NEURONDATA, 0);
+	for (int n=0; n<neurons; n++)
+	{
+		int* neuron=&data[(size_t)n * NEURONDATA];
+		neuron[0]=1;
+		for (int j=0; j<length; j++) neuron[1 + j]=rng() & 0xFF;
+		neuron[NeuroMemAI::NEURONSIZE + 1]=length * 64;
+		neuron[NeuroMemAI::NEURONSIZE + 2]=2;
+		neuron[NeuroMemAI::NEURONSIZE + 3]=1 + n % 10;
+	}
+	std::vector<int> vectors((size_t)CALLS * length);
+	for (size_t i=0; i<vectors.size(); i++) vectors[i]=rng() & 0xFF;
+
+	hNN.writeNeurons(data.data(), neurons);
+	report(p, burst, length, neurons, "writeNeurons", 1, device);
+	hNN.readNeurons(data.data());
+	report(p, burst, length, neurons, "readNeurons", 1, device);
+
+	int distance, category, nid;
+	for (int i=0; i<CALLS; i++) hNN.classify(&vectors[(size_t)i * length], length, &distance, &category, &nid);
+	report(p, burst, length, neurons, "classify", CALLS, device);
+	int K=10, distances[10], categories[10], nids[10];
+	for (int i=0; i<CALLS; i++) hNN.classify(&vectors[(size_t)i * length], length, K, distances, categories, nids);
+	report(p, burst, length, neurons, "classifyK10", CALLS, device);
+	for (int i=0; i<CALLS; i++) hNN.learn(&vectors[(size_t)i * length], length, 11 + i % 10);
+	report(p, burst, length, neurons, "learn", CALLS, device);
+
+	if (hNN.saveKnowledge_SDcard((char*)"bench_bus.knf")!=0) exit(1);
+	report(p, burst, length, neurons, "saveKnowledge", 1, device);
+	if (hNN.loadKnowledge_SDcard((char*)"bench_bus.knf")!=0) exit(1);
+	report(p, burst, length, neurons, "loadKnowledge", 1, device);
+	SD.remove("bench_bus.knf");
+	SPI.attach(p.pin, 0);
+}
+
+int main(int argc, char* argv[])
+{
+	json=(argc > 1) && (strcmp(argv[1], "json")==0);
+	int maxNeurons=argc > 2 ? atoi(argv[2]) : 4096;
+	static const int lengths[5]={ 16, 32, 64, 128, 256 };
+	static const int counts[5]={ 64, 576, 1024, 2048, 4096 };
+
+	if (!json) printf("platform,clock_hz,burst,length,neurons,operation,calls,transactions,bytes,us_per_call\n");
+	for (int p=0; p<3; p++)
+	{
+		for (int burst=1; burst>=0; burst--)
+		{
+			for (int l=0; l<5; l++)
+			{
+				for (int c=0; (c<5) && (counts[c] <= maxNeurons); c++)
+				{
+					bench(platforms[p], burst!=0, lengths[l], counts[c]);
+					fflush(stdout);
+				}
+			}
+		}
+	}
+	return(0);
+}
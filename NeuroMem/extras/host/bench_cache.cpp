@@ -0,0 +1,94 @@
+/************************************************************************/
+/*
+ *	bench_cache.cpp	--	Responses of near-identical frames from NeuroMemResultCache
+ *
+ *  A NeuroShield (NeuroMemSPIDevice, 576 neurons) learns the 256-component
+ *  subsample vectors of 8 scenes. A sequence of frames then shows each scene,
+ *  or a scene which was not learned, for 60 frames, with a noise of +/-noise
+ *  levels per component, and learns one more frame every 250 frames, which
+ *  drops the entries of the cache. For each threshold, report the hits, the
+ *  modeled bus time per frame, and the frames whose category or status is not
+ *  the one of classify on the same vector.
+ *
+ *  bench_cache [frames=2000] [noise=4]
+ *
+ *  From the NeuroMem folder:
+ *  g++ -O2 -std=c++11 -Iextras/host -I. extras/host/bench_cache.cpp NeuroMemAI.cpp NeuroMemSPI.cpp \
+ *      NeuroMemTrace.cpp NeuroMemKnowledge.cpp extras/host/NeuroMemSPIDevice.cpp extras/host/NeuroMemEmu.cpp \
+ *      extras/host/NeuroMemStore.cpp extras/host/NeuroMemKernels.cpp extras/host/ArduinoHost.cpp -o bench_cache
+ */
+/******************************************************************************/
+
+#include <NeuroMemResultCache.h>
+#include "NeuroMemEmu.h"
+#include "NeuroMemSPIDevice.h"
+
+#include <random>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const int LENGTH=256, SCENES=8;
+
+static void frame(const std::vector<int> &scenes, int scene, int noise, std::mt19937 &rng, int vector[])
+{
+	for (int i=0; i<LENGTH; i++)
+	{
+		int v=scenes[(size_t)scene * LENGTH + i] + (int)(rng() % (2 * noise + 1)) - noise;
+		vector[i]=v < 0 ? 0 : (v > 255 ? 255 : v);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int frames=argc > 1 ? atoi(argv[1]) : 2000;
+	int noise=argc > 2 ? atoi(argv[2]) : 4;
+
+	std::mt19937 rng(1);
+	std::vector<int> scenes((size_t)(SCENES + 1) * LENGTH); // the last one is not learned
+	for (size_t i=0; i<scenes.size(); i++) scenes[i]=(int)(rng() & 0xFF);
+
+	static const long thresholds[]={ -1, 0, 256, 1024, 2048, 4096 };
+	printf("threshold,hits,misses,us_per_frame,differences\n");
+	for (size_t t=0; t<sizeof(thresholds) / sizeof(thresholds[0]); t++)
+	{
+		NeuroMemEmu emu(576);
+		NeuroMemSPIDevice device(&emu);
+		SPI.attach(7, &device);
+		NeuroMemAI hNN;
+		if (hNN.begin()!=0) { fprintf(stderr, "NeuroShield not found\n"); return(1); }
+		int vector[LENGTH];
+		std::mt19937 learning(2);
+		for (int s=0; s<SCENES; s++)
+		{
+			for (int k=0; k<4; k++)
+			{
+				frame(scenes, s, noise, learning, vector);
+				hNN.learn(vector, LENGTH, s + 1);
+			}
+		}
+
+		NeuroMemResultCache<LENGTH, 4> cache(hNN);
+		cache.threshold=thresholds[t] < 0 ? 0 : thresholds[t];
+		double bus=0;
+		int differences=0;
+		std::mt19937 sequence(3);
+		for (int f=0; f<frames; f++)
+		{
+			int scene=(f / 60) % (SCENES + 1);
+			frame(scenes, scene, noise, sequence, vector);
+			int d, c, n, d0, c0, n0, status;
+			device.clearCounters();
+			if (thresholds[t] < 0) status=hNN.classify(vector, LENGTH, &d, &c, &n); // without cache
+			else status=cache.classify(vector, LENGTH, &d, &c, &n);
+			bus+=device.busMicros;
+			int reference=hNN.classify(vector, LENGTH, &d0, &c0, &n0);
+			if ((status!=reference) || (c!=c0)) differences++;
+			if ((f % 250==249) && (scene < SCENES)) hNN.learn(vector, LENGTH, scene + 1);
+		}
+		if (thresholds[t] < 0) printf("none,0,%d,%.0f,0\n", frames, bus / frames);
+		else printf("%ld,%lu,%lu,%.0f,%d\n", thresholds[t], cache.hits, cache.misses, bus / frames, differences);
+		SPI.attach(7, 0);
+	}
+	return(0);
+}
@@ -0,0 +1,143 @@
+/************************************************************************/
+/*
+ *	bench_cluster.cpp	--	Several NeuroMem devices on the same SPI bus
+ *
+ *  NeuroShields of 192 neurons are emulated on the chip selects 7, 4, 3 and 2
+ *  (NeuroMemSPIDevice), each driven by its own NeuroMemAI, and grouped in a
+ *  NeuroMemCluster. For 1 to 4 devices, the cluster learns vectors of 40
+ *  categories until it is full, then classifies test vectors. Report the
+ *  committed neurons, the answers, and the modeled bus time per classify.
+ *  The neurons of the cluster are then copied into one emulated network of
+ *  the same capacity, and the K=10 responses of the cluster must be the
+ *  same as those of this network (exit status 1 otherwise).
+ *
+ *  From the NeuroMem folder:
+ *  g++ -O2 -std=c++11 -Iextras/host -I. extras/host/bench_cluster.cpp NeuroMemCluster.cpp NeuroMemAI.cpp \
+ *      NeuroMemSPI.cpp NeuroMemTrace.cpp NeuroMemKnowledge.cpp extras/host/NeuroMemSPIDevice.cpp \
+ *      extras/host/NeuroMemEmu.cpp extras/host/NeuroMemStore.cpp extras/host/NeuroMemKernels.cpp \
+ *      extras/host/ArduinoHost.cpp -o bench_cluster
+ */
+/******************************************************************************/
+
+#include <NeuroMemCluster.h>
+#include "NeuroMemEmu.h"
+#include "NeuroMemSPIDevice.h"
+
+#include <random>
+#include <vector>
+#include <stdio.h>
+
+static const int CAPACITY=192; // neurons per device
+static const int LENGTH=32;
+static const int CATEGORIES=40;
+static const int TESTS=200;
+static const int NEURONDATA=NeuroMemAI::NEURONSIZE + 4;
+static const int pins[4]={ 7, 4, 3, 2 };
+
+struct Device
+{
+	NeuroMemEmu emu;
+	NeuroMemSPIDevice spi;
+	NeuroMemAI nm;
+	Device() : emu(CAPACITY), spi(&emu) {}
+};
+
+// vectors around the prototype of their category
+static void sample(const std::vector<int> &prototypes, int category, std::mt19937 &rng, int vector[])
+{
+	for (int j=0; j<LENGTH; j++)
+	{
+		int v=prototypes[(size_t)(category - 1) * LENGTH + j] + (int)(rng() % 81) - 40;
+		vector[j]=v < 0 ? 0 : (v > 255 ? 255 : v);
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(1);
+	std::vector<int> prototypes((size_t)CATEGORIES * LENGTH);
+	for (size_t i=0; i<prototypes.size(); i++) prototypes[i]=(int)(rng() & 0xFF);
+	int errors=0;
+
+	printf("devices,neurons,committed,learned,correct,uncertain,unknown,us_per_classify,us_per_classifyK10\n");
+	for (int ndevices=1; ndevices<=4; ndevices++)
+	{
+		Device devices[4];
+		NeuroMemCluster cluster;
+		for (int i=0; i<ndevices; i++)
+		{
+			SPI.attach(pins[i], &devices[i].spi);
+			if (devices[i].nm.begin(2, pins[i], 2000000)!=0) { fprintf(stderr, "device %d not found\n", i); return(1); }
+			cluster.add(&devices[i].nm);
+		}
+		cluster.setContext(1, 2, 0x300);
+
+		// learn until the cluster is full
+		int vector[LENGTH], learned=0;
+		long committed=0;
+		std::mt19937 data(2);
+		while ((committed < cluster.navail()) && (learned < 100000))
+		{
+			int category=1 + learned % CATEGORIES;
+			sample(prototypes, category, data, vector);
+			committed=cluster.learn(vector, LENGTH, category);
+			learned++;
+		}
+
+		// classify
+		for (int i=0; i<ndevices; i++) devices[i].spi.clearCounters();
+		int correct=0, uncertain=0, unknown=0;
+		std::vector<int> tests((size_t)TESTS * LENGTH);
+		std::mt19937 test(3);
+		for (int t=0; t<TESTS; t++)
+		{
+			int category=1 + t % CATEGORIES, d, c, n;
+			sample(prototypes, category, test, &tests[(size_t)t * LENGTH]);
+			int status=cluster.classify(&tests[(size_t)t * LENGTH], LENGTH, &d, &c, &n);
+			if (status==0) unknown++;
+			else if (status==4) uncertain++;
+			else if ((c & 0x7FFF)==category) correct++;
+		}
+		double bus=0;
+		for (int i=0; i<ndevices; i++) { bus+=devices[i].spi.busMicros; devices[i].spi.clearCounters(); }
+		int K=10, dists[10], cats[10], nids[10];
+		std::vector<int> responses((size_t)TESTS * 3 * K);
+		for (int t=0; t<TESTS; t++)
+		{
+			cluster.classify(&tests[(size_t)t * LENGTH], LENGTH, K, dists, cats, nids);
+			for (int k=0; k<K; k++)
+			{
+				responses[((size_t)t * K + k) * 3]=dists[k];
+				responses[((size_t)t * K + k) * 3 + 1]=cats[k];
+				responses[((size_t)t * K + k) * 3 + 2]=nids[k];
+			}
+		}
+		double busK=0;
+		for (int i=0; i<ndevices; i++) busK+=devices[i].spi.busMicros;
+		printf("%d,%ld,%ld,%d,%d,%d,%d,%.0f,%.0f\n", ndevices, cluster.navail(), cluster.ncount(), learned,
+			correct, uncertain, unknown, bus / TESTS, busK / TESTS);
+
+		// the same neurons in one network
+		NeuroMemEmu single(CAPACITY * ndevices);
+		NeuroMemAI one;
+		one.begin(&single);
+		std::vector<int> neurons((size_t)CAPACITY * ndevices * NEURONDATA);
+		long count=0;
+		for (int i=0; i<ndevices; i++) count+=devices[i].nm.readNeurons(&neurons[(size_t)count * NEURONDATA]);
+		one.writeNeurons(neurons.data(), (int)count);
+		one.setContext(1, 2, 0x300);
+		for (int t=0; t<TESTS; t++)
+		{
+			one.classify(&tests[(size_t)t * LENGTH], LENGTH, K, dists, cats, nids);
+			for (int k=0; k<K; k++)
+			{
+				if ((responses[((size_t)t * K + k) * 3]!=dists[k]) || (responses[((size_t)t * K + k) * 3 + 1]!=cats[k])
+					|| (responses[((size_t)t * K + k) * 3 + 2]!=nids[k])) errors++;
+			}
+		}
+
+		for (int i=0; i<ndevices; i++) SPI.attach(pins[i], 0);
+	}
+	if (errors!=0) fprintf(stderr, "%d responses differ from a single network\n", errors);
+	return(errors==0 ? 0 : 1);
+}
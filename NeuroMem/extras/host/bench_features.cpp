@@ -0,0 +1,253 @@
+/************************************************************************/
+/*
+ *	bench_features.cpp	--	Frames per second of the feature extraction
+ *
+ *  Feed synthetic 320x240 RGB565 frames line by line to the extractors of
+ *  NeuroMemFeatures.h, on the region of interest of the example (128x128
+ *  pixels in the center, blocks of 8x8 pixels), and report the frames per
+ *  second of each one, and of the per-pixel loop of the former example
+ *  sketch (divides, bounds checks, long accumulators) for comparison.
+ *  The camera and the SPI transfer of the lines are not included.
+ *  The vectors of the three extractors are verified against a direct
+ *  computation on the whole frame, also for regions at the edges of the
+ *  frame and for 1, 3 and 5 bits per color (exit status 1 if they differ).
+ *
+ *  bench_features [frames=2000]
+ *
+ *  From the NeuroMem folder:
+ *  g++ -O2 -std=c++11 -I. extras/host/bench_features.cpp -o bench_features
+ */
+/******************************************************************************/
+
+#include <NeuroMemFeatures.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static const int FW=320, FH=240; // frame
+static const int RW=128, RH=128; // region of interest
+static const int RLEFT=(FW - RW) / 2, RTOP=(FH - RH) / 2;
+static const int BW=8, BH=8; // blocks
+static const int HB=RW / BW, VB=RH / BH;
+
+typedef NeuroMemSubsample<FW, RLEFT, RTOP, BW, BH, HB, VB> Subsample;
+typedef NeuroMemRGBHistogram<FW, RLEFT, RTOP, RW, RH, 3> RGBHistogram;
+typedef NeuroMemEdgeHistogram<FW, RLEFT, RTOP, 32, 32, 4, 4> EdgeHistogram;
+
+static volatile int sink; // keeps the results alive
+
+// ------------------------------------------------------------
+// Per-pixel loop of the former getFeatureVectors of the example
+// ------------------------------------------------------------
+static void former(const std::vector<uint8_t> &frame, int vector[])
+{
+	static long subsample[256];
+	int rleft=RLEFT, rtop=RTOP, rright=RLEFT + RW, rbottom=RTOP + RH;
+	int bw=BW, bh=BH, hb=HB, vb=VB, vlen=HB * VB;
+	for (int i=0; i<vlen; i++) subsample[i]=0;
+	for (int y=0; y<FH; y++)
+	{
+		const uint8_t* line=&frame[(size_t)y * FW * 2];
+		for (int x=0; x<FW; x++)
+		{
+			int color=(line[x * 2] << 8) + line[x * 2 + 1];
+			if ((y >= rtop) && (y < rbottom))
+			{
+				int indexY=(y - rtop) / bh;
+				if ((x >= rleft) && (x < rright))
+				{
+					int greylevel=((color >> 11) & 0x1F) + ((color >> 5) & 0x1F) + (color & 0x1F);
+					int indexX=(x - rleft) / bw;
+					if ((indexX < hb) & (indexY < vb)) subsample[indexY * hb + indexX]+=greylevel;
+				}
+			}
+		}
+	}
+	for (int i=0; i<vlen; i++) vector[i]=(uint8_t)(subsample[i] / (bw * bh));
+}
+
+template <class Extractor> static void extract(Extractor &extractor, const std::vector<uint8_t> &frame,
+	uint8_t vector[])
+{
+	extractor.begin();
+	for (int y=0; y<FH; y++) extractor.addLine(&frame[(size_t)y * FW * 2]);
+	extractor.getVector(vector);
+}
+
+static int grey(const std::vector<uint8_t> &frame, int x, int y)
+{
+	return(NeuroMemRGB565::grey(&frame[((size_t)y * FW + x) * 2]));
+}
+
+// ------------------------------------------------------------
+// Histograms computed from the 16-bit colors of the region,
+// with the bin of a level as level * bins / levels
+// ------------------------------------------------------------
+template <int LEFT, int TOP, int W, int H, int BITS> static int checkRGB(const std::vector<std::vector<uint8_t> > &frames)
+{
+	NeuroMemRGBHistogram<FW, LEFT, TOP, W, H, BITS> histogram;
+	static const int BINS=1 << BITS;
+	int errors=0;
+	uint8_t vector[256];
+	for (size_t f=0; f<frames.size(); f++)
+	{
+		extract(histogram, frames[f], vector);
+		std::vector<long> counts(3 * BINS, 0);
+		for (int y=TOP; y<TOP + H; y++)
+		{
+			for (int x=LEFT; x<LEFT + W; x++)
+			{
+				int color=(frames[f][((size_t)y * FW + x) * 2] << 8) | frames[f][((size_t)y * FW + x) * 2 + 1];
+				counts[((color >> 11) & 0x1F) * BINS / 32]++;
+				counts[BINS + ((color >> 5) & 0x3F) * BINS / 64]++;
+				counts[2 * BINS + (color & 0x1F) * BINS / 32]++;
+			}
+		}
+		for (int i=0; i<3 * BINS; i++) if (vector[i]!=counts[i] * 255 / ((long)W * H)) errors++;
+	}
+	if (errors!=0) fprintf(stderr, "NeuroMemRGBHistogram<%d, %d, %d, %d, %d, %d>: %d components differ\n", FW, LEFT, TOP, W, H, BITS, errors);
+	return(errors);
+}
+
+// ------------------------------------------------------------
+// Edges computed on the grey levels of the whole frame: the
+// gradient is null toward the outside of the region, left of
+// its first column and above its first row
+// ------------------------------------------------------------
+template <int LEFT, int TOP, int BW, int BH, int HB, int VB, int THRESHOLD>
+static int checkEdges(const std::vector<std::vector<uint8_t> > &frames)
+{
+	NeuroMemEdgeHistogram<FW, LEFT, TOP, BW, BH, HB, VB, THRESHOLD> edges;
+	int errors=0;
+	uint8_t vector[256];
+	for (size_t f=0; f<frames.size(); f++)
+	{
+		extract(edges, frames[f], vector);
+		std::vector<long> counts(4 * HB * VB, 0);
+		for (int y=TOP; y<TOP + VB * BH; y++)
+		{
+			for (int x=LEFT; x<LEFT + HB * BW; x++)
+			{
+				int gx=x > LEFT ? grey(frames[f], x, y) - grey(frames[f], x - 1, y) : 0;
+				int gy=y > TOP ? grey(frames[f], x, y) - grey(frames[f], x, y - 1) : 0;
+				int ax=abs(gx), ay=abs(gy);
+				if (ax + ay < THRESHOLD) continue;
+				long* block=&counts[(((y - TOP) / BH) * HB + (x - LEFT) / BW) * 4];
+				if (ax > 2 * ay) block[0]++;
+				else if (ay > 2 * ax) block[1]++;
+				else if ((gx > 0) == (gy > 0)) block[2]++;
+				else block[3]++;
+			}
+		}
+		for (int i=0; i<4 * HB * VB; i++) if (vector[i]!=counts[i] * 255 / (BW * BH)) errors++;
+	}
+	if (errors!=0) fprintf(stderr, "NeuroMemEdgeHistogram<%d, %d, %d, %d, %d, %d, %d, %d>: %d components differ\n",
+		FW, LEFT, TOP, BW, BH, HB, VB, THRESHOLD, errors);
+	return(errors);
+}
+
+static double fps(Clock::time_point start, int frames)
+{
+	return(frames / std::chrono::duration<double>(Clock::now() - start).count());
+}
+
+int main(int argc, char* argv[])
+{
+	int frames=argc > 1 ? atoi(argv[1]) : 2000;
+
+	// 8 frames of shapes and noise
+	std::mt19937 rng(1);
+	std::vector<std::vector<uint8_t> > images(8, std::vector<uint8_t>((size_t)FW * FH * 2));
+	for (size_t f=0; f<images.size(); f++)
+	{
+		for (int y=0; y<FH; y++)
+		{
+			for (int x=0; x<FW; x++)
+			{
+				int r=(x + (int)f * 13) & 0x1F, g=((y * 2) ^ x) & 0x3F, b=((x - 160) * (x - 160) + (y - 120) * (y - 120) < 2500) ? 0x1F : (int)(rng() & 0x07);
+				uint16_t color=(uint16_t)((r << 11) | (g << 5) | b);
+				images[f][((size_t)y * FW + x) * 2]=(uint8_t)(color >> 8);
+				images[f][((size_t)y * FW + x) * 2 + 1]=(uint8_t)(color & 0xFF);
+			}
+		}
+	}
+
+	// verify the extractors against a direct computation, also on
+	// frames of random colors and of the extreme colors
+	std::vector<std::vector<uint8_t> > checked(images);
+	checked.push_back(std::vector<uint8_t>((size_t)FW * FH * 2, 0x00));
+	checked.push_back(std::vector<uint8_t>((size_t)FW * FH * 2, 0xFF));
+	checked.push_back(std::vector<uint8_t>((size_t)FW * FH * 2));
+	for (size_t i=0; i<checked.back().size(); i++) checked.back()[i]=(uint8_t)rng();
+	int errors=0;
+	Subsample subsample;
+	uint8_t vector[256];
+	for (size_t f=0; f<images.size(); f++)
+	{
+		extract(subsample, images[f], vector);
+		for (int by=0; by<VB; by++)
+		{
+			for (int bx=0; bx<HB; bx++)
+			{
+				long sum=0;
+				for (int y=RTOP + by * BH; y<RTOP + (by + 1) * BH; y++)
+					for (int x=RLEFT + bx * BW; x<RLEFT + (bx + 1) * BW; x++)
+						sum+=NeuroMemRGB565::grey(&images[f][((size_t)y * FW + x) * 2]);
+				if (vector[by * HB + bx]!=sum / (BW * BH)) errors++;
+			}
+		}
+	}
+	if (errors!=0) fprintf(stderr, "NeuroMemSubsample: %d components differ\n", errors);
+	errors+=checkRGB<RLEFT, RTOP, RW, RH, 3>(checked);
+	errors+=checkRGB<0, 0, FW, FH, 1>(checked);
+	errors+=checkRGB<FW - 64, FH - 64, 64, 64, 5>(checked);
+	errors+=checkEdges<RLEFT, RTOP, 32, 32, 4, 4, 32>(checked);
+	errors+=checkEdges<0, 0, 8, 8, 40, 1, 16>(checked); // first line of the frame, whole width
+	errors+=checkEdges<FW - 48, FH - 24, 16, 8, 3, 3, 1>(checked);
+
+	printf("extractor,length,frames_per_second\n");
+	int former_vector[256];
+	Clock::time_point start=Clock::now();
+	for (int f=0; f<frames; f++) { former(images[f & 7], former_vector); sink=former_vector[0]; }
+	printf("former example,%d,%.0f\n", HB * VB, fps(start, frames));
+
+	start=Clock::now();
+	for (int f=0; f<frames; f++) { extract(subsample, images[f & 7], vector); sink=vector[0]; }
+	printf("NeuroMemSubsample,%d,%.0f\n", Subsample::LENGTH, fps(start, frames));
+
+	RGBHistogram histogram;
+	start=Clock::now();
+	for (int f=0; f<frames; f++) { extract(histogram, images[f & 7], vector); sink=vector[0]; }
+	printf("NeuroMemRGBHistogram,%d,%.0f\n", RGBHistogram::LENGTH, fps(start, frames));
+
+	EdgeHistogram edges;
+	start=Clock::now();
+	for (int f=0; f<frames; f++) { extract(edges, images[f & 7], vector); sink=vector[0]; }
+	printf("NeuroMemEdgeHistogram,%d,%.0f\n", EdgeHistogram::LENGTH, fps(start, frames));
+
+	// the three features from the same lines
+	start=Clock::now();
+	uint8_t v2[256], v3[256];
+	for (int f=0; f<frames; f++)
+	{
+		const std::vector<uint8_t> &frame=images[f & 7];
+		subsample.begin(); histogram.begin(); edges.begin();
+		for (int y=0; y<FH; y++)
+		{
+			const uint8_t* line=&frame[(size_t)y * FW * 2];
+			subsample.addLine(line);
+			histogram.addLine(line);
+			edges.addLine(line);
+		}
+		subsample.getVector(vector); histogram.getVector(v2); edges.getVector(v3);
+		sink=vector[0] + v2[0] + v3[0];
+	}
+	printf("all three,%d,%.0f\n", Subsample::LENGTH + RGBHistogram::LENGTH + EdgeHistogram::LENGTH, fps(start, frames));
+
+	return(errors==0 ? 0 : 1);
+}
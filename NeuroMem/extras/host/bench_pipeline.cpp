@@ -0,0 +1,159 @@
+/************************************************************************/
+/*
+ *	bench_pipeline.cpp	--	Recognition of 3 features of a frame in 3 contexts
+ *
+ *  NeuroMemPipeline extracts a subsample (context 1), a RGB histogram
+ *  (context 2) and an edge histogram (context 3) of the center of synthetic
+ *  320x240 frames in one pass over the lines, learns 10 patterns, then
+ *  classifies noisy frames of these patterns with each combination policy.
+ *  Report the answers per policy, the time per frame of each feature on the
+ *  host, and the writes of GCR, MINIF and MAXIF per frame, compared to
+ *  a setContext before each feature in a fixed order.
+ *
+ *  bench_pipeline [frames=200]
+ *
+ *  From the NeuroMem folder:
+ *  g++ -O2 -std=c++11 -Iextras/host -I. extras/host/bench_pipeline.cpp NeuroMemPipeline.cpp NeuroMemAI.cpp \
+ *      NeuroMemSPI.cpp NeuroMemTrace.cpp NeuroMemKnowledge.cpp extras/host/NeuroMemEmu.cpp \
+ *      extras/host/NeuroMemStore.cpp extras/host/NeuroMemKernels.cpp extras/host/ArduinoHost.cpp -o bench_pipeline
+ */
+/******************************************************************************/
+
+#include <NeuroMemPipeline.h>
+#include "NeuroMemEmu.h"
+
+#include <random>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const int FW=320, FH=240, PATTERNS=10;
+
+// counts the writes of the context registers
+class ContextCounter : public NeuroMemTransport
+{
+	public:
+
+		ContextCounter(NeuroMemTransport* network) : network(network) {}
+		int read(unsigned char mod, unsigned char reg) { return(network->read(mod, reg)); }
+		void write(unsigned char mod, unsigned char reg, int data)
+		{
+			if ((reg==0x0B) || (reg==0x06) || (reg==0x07)) writes++; // GCR, MINIF, MAXIF
+			network->write(mod, reg, data);
+		}
+		void writeAddr(long addr, int length, int data[]) { network->writeAddr(addr, length, data); }
+		void readAddr(long addr, int length, int data[]) { network->readAddr(addr, length, data); }
+		long writes=0;
+
+	private:
+
+		NeuroMemTransport* network;
+};
+
+// pattern p: colored stripes and a disk, plus noise and a brightness offset
+static void frame(std::vector<uint8_t> &pixels, int p, int noise, int offset, std::mt19937 &rng)
+{
+	for (int y=0; y<FH; y++)
+	{
+		for (int x=0; x<FW; x++)
+		{
+			int r=((x * (p + 1)) >> 4) & 0x1F, g=((y * (PATTERNS - p)) >> 3) & 0x3F, b=(p * 3) & 0x1F;
+			int dx=x - 120 - p * 8, dy=y - 120;
+			if (dx * dx + dy * dy < 900) { r=0x1F - r; g=0x3F - g; }
+			if (noise > 0)
+			{
+				r+=(int)(rng() % (2 * noise + 1)) - noise + offset;
+				g+=2 * ((int)(rng() % (2 * noise + 1)) - noise + offset);
+			}
+			r=r < 0 ? 0 : (r > 0x1F ? 0x1F : r);
+			g=g < 0 ? 0 : (g > 0x3F ? 0x3F : g);
+			uint16_t color=(uint16_t)((r << 11) | (g << 5) | b);
+			pixels[((size_t)y * FW + x) * 2]=(uint8_t)(color >> 8);
+			pixels[((size_t)y * FW + x) * 2 + 1]=(uint8_t)(color & 0xFF);
+		}
+	}
+}
+
+static void feed(NeuroMemPipeline &pipeline, const std::vector<uint8_t> &pixels)
+{
+	pipeline.begin();
+	for (int y=0; y<FH; y++) pipeline.addLine(&pixels[(size_t)y * FW * 2]);
+}
+
+int main(int argc, char* argv[])
+{
+	int frames=argc > 1 ? atoi(argv[1]) : 200;
+
+	NeuroMemEmu emu(576);
+	ContextCounter counter(&emu);
+	NeuroMemAI hNN;
+	if (hNN.begin(&counter)!=0) return(1);
+
+	NeuroMemFeatureStage<NeuroMemSubsample<FW, 96, 56, 8, 8, 16, 16> > subsample;
+	NeuroMemFeatureStage<NeuroMemRGBHistogram<FW, 96, 56, 128, 128, 3> > histogram;
+	NeuroMemFeatureStage<NeuroMemEdgeHistogram<FW, 96, 56, 32, 32, 4, 4, 64> > edges;
+	NeuroMemPipeline pipeline(hNN);
+	pipeline.add(&subsample, 1, 2, 0x4000);
+	pipeline.add(&histogram, 2, 2, 0x1000);
+	pipeline.add(&edges, 3, 2, 0x2000);
+	const char* names[3]={ "subsample", "rgb histogram", "edge histogram" };
+	NeuroMemFeature* stages[3]={ &subsample, &histogram, &edges };
+
+	std::mt19937 rng(1);
+	std::vector<uint8_t> pixels((size_t)FW * FH * 2);
+	for (int p=0; p<PATTERNS; p++)
+	{
+		frame(pixels, p, 0, 0, rng);
+		feed(pipeline, pixels);
+		pipeline.learn(p + 1);
+	}
+	printf("%d neurons committed\n", hNN.NCOUNT());
+
+	static const char* policies[3]={ "unanimity", "best distance", "vote" };
+	for (int policy=0; policy<3; policy++)
+	{
+		pipeline.policy=policy;
+		pipeline.clearTimings();
+		counter.writes=0;
+		int correct=0, wrong=0, unknown=0, distance;
+		std::mt19937 noise(2);
+		for (int f=0; f<frames; f++)
+		{
+			frame(pixels, f % PATTERNS, 3, (f % 5) - 2, noise);
+			feed(pipeline, pixels);
+			int category=pipeline.classify(&distance);
+			if (category==0xFFFF) unknown++;
+			else if (category==f % PATTERNS + 1) correct++;
+			else wrong++;
+		}
+		printf("%s: %d correct, %d wrong, %d unknown, %.1f context switches and %.1f register writes per frame\n",
+			policies[policy], correct, wrong, unknown, (double)pipeline.contextSwitches / frames,
+			(double)counter.writes / frames);
+		if (policy==2)
+		{
+			for (int i=0; i<3; i++)
+			{
+				printf("  %s: %d components, lines %.0f us, vector and classify %.0f us per frame\n", names[i],
+					stages[i]->length, (double)stages[i]->extractMicros / frames,
+					(double)stages[i]->classifyMicros / frames);
+			}
+		}
+	}
+
+	// a setContext before each feature, in a fixed order
+	counter.writes=0;
+	int vector[256];
+	for (int f=0; f<frames; f++)
+	{
+		feed(pipeline, pixels);
+		for (int i=0; i<3; i++)
+		{
+			int d, c, n;
+			hNN.setContext(stages[i]->context, stages[i]->minif, stages[i]->maxif);
+			int length=stages[i]->getVector(vector);
+			hNN.classify(vector, length, &d, &c, &n);
+		}
+	}
+	printf("fixed order: %.1f register writes per frame\n", (double)counter.writes / frames);
+	return(0);
+}
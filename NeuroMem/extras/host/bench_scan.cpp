@@ -0,0 +1,119 @@
+/************************************************************************/
+/*
+ *	bench_scan.cpp	--	Search of an object in a frame with NeuroMemScanner
+ *
+ *  A textured object of 96x96 pixels is learned in a first 320x240 frame,
+ *  with 4 windows of the background as counter-examples, then searched
+ *  in a second frame where it has moved, with windows of 12 and 16 cells
+ *  of 8x8 pixels every 4 cells. The frames are fed line by line to
+ *  NeuroMemScanner, and the windows are classified by NeuroMemAI
+ *  through NeuroMemSPI and NeuroMemSPIDevice on the NeuroShield (2 MHz).
+ *  Report the hits, the time of the pass over the lines and of the
+ *  computation of the vectors on the host, and the modeled bus time of
+ *  the classifications. Exit status 1 if the object is not found.
+ *
+ *  From the NeuroMem folder:
+ *  g++ -O2 -std=c++11 -Iextras/host -I. extras/host/bench_scan.cpp NeuroMemAI.cpp NeuroMemSPI.cpp NeuroMemTrace.cpp \
+ *      NeuroMemKnowledge.cpp extras/host/NeuroMemSPIDevice.cpp extras/host/NeuroMemEmu.cpp \
+ *      extras/host/NeuroMemStore.cpp extras/host/NeuroMemKernels.cpp extras/host/ArduinoHost.cpp -o bench_scan
+ */
+/******************************************************************************/
+
+#include <NeuroMemAI.h>
+#include <NeuroMemScanner.h>
+#include "NeuroMemEmu.h"
+#include "NeuroMemSPIDevice.h"
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <stdio.h>
+
+typedef std::chrono::steady_clock Clock;
+typedef NeuroMemScanner<320, 240, 8, 8> Scanner;
+
+static const int FW=320, FH=240, CELL=8;
+static const int OBJECT=96; // side of the object, in pixels
+
+// background of noise, and the object at (ox, oy)
+static void frame(std::vector<uint8_t> &pixels, int ox, int oy, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	for (int y=0; y<FH; y++)
+	{
+		for (int x=0; x<FW; x++)
+		{
+			int grey=96 + (int)(rng() % 32);
+			if ((x >= ox) && (x < ox + OBJECT) && (y >= oy) && (y < oy + OBJECT))
+			{
+				int u=x - ox, v=y - oy;
+				grey=((u / 24 + v / 16) & 1) ? 240 : 16; // checkerboard
+				if ((u - 48) * (u - 48) + (v - 48) * (v - 48) < 400) grey=128;
+			}
+			uint16_t color=(uint16_t)(((grey >> 3) << 11) | ((grey >> 2) << 5) | (grey >> 3));
+			pixels[((size_t)y * FW + x) * 2]=(uint8_t)(color >> 8);
+			pixels[((size_t)y * FW + x) * 2 + 1]=(uint8_t)(color & 0xFF);
+		}
+	}
+}
+
+static double elapsed(Clock::time_point start)
+{
+	return(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+}
+
+int main()
+{
+	NeuroMemEmu emu(576);
+	NeuroMemSPIDevice device(&emu);
+	SPI.attach(7, &device);
+	NeuroMemAI hNN;
+	if (hNN.begin()!=0) return(1);
+
+	std::vector<uint8_t> pixels((size_t)FW * FH * 2);
+	Scanner scanner;
+	int vector[Scanner::LENGTH];
+
+	// learn the object at (64, 48), cells (8, 6)
+	frame(pixels, 64, 48, 1);
+	scanner.begin();
+	for (int y=0; y<FH; y++) scanner.addLine(&pixels[(size_t)y * FW * 2]);
+	scanner.getVector(64 / CELL, 48 / CELL, OBJECT / CELL, vector);
+	hNN.learn(vector, Scanner::LENGTH, 1);
+	// and background windows as category 0, which reduce the influence field of the object
+	static const int background[4][2]={ { 0, 0 }, { 28, 0 }, { 0, 18 }, { 28, 18 } };
+	for (int i=0; i<4; i++)
+	{
+		scanner.getVector(background[i][0], background[i][1], OBJECT / CELL, vector);
+		hNN.learn(vector, Scanner::LENGTH, 0);
+	}
+
+	// search it at (192, 128)
+	frame(pixels, 192, 128, 2);
+	Clock::time_point start=Clock::now();
+	scanner.begin();
+	for (int y=0; y<FH; y++) scanner.addLine(&pixels[(size_t)y * FW * 2]);
+	double linesUs=elapsed(start);
+
+	NeuroMemWindowScale scales[2]={ { 12, 4 }, { 16, 4 } };
+	NeuroMemWindowHit hits[16];
+	device.clearCounters();
+	start=Clock::now();
+	int nhits=scanner.scan(hNN, scales, 2, hits, 16);
+	double scanUs=elapsed(start);
+
+	bool found=false;
+	for (int i=0; i<nhits; i++)
+	{
+		printf("hit x=%d y=%d size=%d category=%d distance=%d\n", hits[i].x, hits[i].y, hits[i].size,
+			hits[i].category, hits[i].distance);
+		if ((hits[i].x==192) && (hits[i].y==128) && (hits[i].size==OBJECT) && (hits[i].category==1)) found=true;
+	}
+	printf("%d windows of %d components, %d hits\n", scanner.windows, Scanner::LENGTH, nhits);
+	printf("lines %.0f us, scan %.0f us on the host\n", linesUs, scanUs);
+	printf("bus %lu transactions, %lu bytes, %.1f ms at 2 MHz, %.2f ms per window\n", device.transactions,
+		device.bytes, device.busMicros / 1000, device.busMicros / 1000 / scanner.windows);
+	SPI.attach(7, 0);
+	if (!found) fprintf(stderr, "object not found\n");
+	return(found ? 0 : 1);
+}
@@ -0,0 +1,65 @@
+/************************************************************************/
+/*																		
+ *	bench_shards.cpp	--	Scaling of NeuroMemShardEngine with the number of cores
+ *
+ *  Classify a batch of random vectors against a store of random neurons
+ *  with 1 to N threads. Output in CSV format:
+ *  threads,neurons,vectors,length,K,mode,seconds,vectors_per_s,speedup
+ *
+ *  bench_shards [neurons=100000] [vectors=2000] [maxThreads=cores] [K=10]
+ *
+ *  g++ -O2 -std=c++11 -pthread bench_shards.cpp NeuroMemStore.cpp NeuroMemKernels.cpp -o bench_shards
+ */
+/******************************************************************************/
+
+#include "NeuroMemShardEngine.h"
+#include "NeuroMemStore.h"
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char* argv[])
+{
+	int neurons=argc > 1 ? atoi(argv[1]) : 100000;
+	int count=argc > 2 ? atoi(argv[2]) : 2000;
+	int maxThreads=argc > 3 ? atoi(argv[3]) : (int)std::thread::hardware_concurrency();
+	int K=argc > 4 ? atoi(argv[4]) : 10;
+	int length=NeuroMemStore::NEURONSIZE;
+	if (maxThreads <= 0) maxThreads=1;
+
+	std::mt19937 rng(1);
+	NeuroMemStore store(neurons);
+	for (int n=0; n<neurons; n++)
+	{
+		for (int j=0; j<length; j++) store.model(n)[j]=(uint8_t)rng();
+		store.ncr[n]=1;
+		store.aif[n]=0x4000;
+		store.minif[n]=2;
+		store.cat[n]=(uint16_t)(1 + n % 10);
+	}
+	store.count=neurons;
+	std::vector<uint8_t> vectors((size_t)count * length);
+	for (size_t i=0; i<vectors.size(); i++) vectors[i]=(uint8_t)rng();
+	std::vector<NeuroMemHit> hits((size_t)count * K);
+	std::vector<int> nhits(count);
+
+	printf("threads,neurons,vectors,length,K,mode,seconds,vectors_per_s,speedup\n");
+	for (int knn=0; knn<2; knn++)
+	{
+		double reference=0;
+		for (int t=1; t<=maxThreads; t++)
+		{
+			NeuroMemShardEngine<NeuroMemStore> engine(store, t);
+			auto t0=std::chrono::steady_clock::now();
+			engine.classify(vectors.data(), count, length, length, 1, knn!=0, K, hits.data(), nhits.data());
+			double seconds=std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+			if (t==1) reference=seconds;
+			printf("%d,%d,%d,%d,%d,%s,%.6f,%.1f,%.2f\n", t, neurons, count, length, K, knn ? "KNN" : "RBF",
+				seconds, count / seconds, reference / seconds);
+			fflush(stdout);
+		}
+	}
+	return(0);
+}
@@ -0,0 +1,127 @@
+/************************************************************************/
+/*
+ *	build_knowledge.cpp	--	Knowledge file built from a file of vectors
+ *
+ *  Read a file of vectors in the CSV format of the NeuroMem Knowledge
+ *  Builder, as written by log2csv from the log of the examples, with all the cores
+ *  of the host (see NeuroMemVectors.h). The vectors are then learned by
+ *  an emulated network (NeuroMemEmu) through NeuroMemAI::learn, in the
+ *  context of their row, with the MINIF and MAXIF given on the command line,
+ *  so the neurons are the ones that the same learning would commit on the
+ *  board. Category 0 is a counter-example. An epoch learns all the vectors,
+ *  in the order of the file or in a new random order if seed is not 0, and
+ *  the learning stops after the last epoch or the first one which does not
+ *  change the neurons. The knowledge is saved with saveKnowledge_SDcard, in
+ *  the V2 format read by loadKnowledge_SDcard.
+ *
+ *  build_knowledge vectors.txt neurons.knf [neurons=576] [minif=2] [maxif=0x4000] [epochs=1] [seed=0] [threads=0]
+ *
+ *  From the NeuroMem folder:
+ *  g++ -O2 -std=c++11 -pthread -Iextras/host -I. extras/host/build_knowledge.cpp extras/host/NeuroMemVectors.cpp \
+ *      NeuroMemAI.cpp NeuroMemSPI.cpp NeuroMemTrace.cpp NeuroMemKnowledge.cpp extras/host/NeuroMemEmu.cpp \
+ *      extras/host/NeuroMemStore.cpp extras/host/NeuroMemKernels.cpp extras/host/ArduinoHost.cpp -o build_knowledge
+ */
+/******************************************************************************/
+
+#include <NeuroMemAI.h>
+#include "NeuroMemEmu.h"
+#include "NeuroMemVectors.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds(Clock::time_point start)
+{
+	return(std::chrono::duration<double>(Clock::now() - start).count());
+}
+
+// hash of the registers of the committed neurons
+static uint64_t state(const NeuroMemStore &neurons)
+{
+	uint64_t h=(uint64_t)neurons.count;
+	for (int i=0; i<neurons.count; i++) h=(h * 1099511628211ULL) ^ ((uint64_t)neurons.aif[i] << 16 | neurons.cat[i]);
+	return(h);
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		fprintf(stderr, "build_knowledge vectors.txt neurons.knf [neurons=576] [minif=2] [maxif=0x4000] [epochs=1] [seed=0] [threads=0]\n");
+		return(2);
+	}
+	int capacity=argc > 3 ? (int)strtol(argv[3], 0, 0) : 576;
+	int minif=argc > 4 ? (int)strtol(argv[4], 0, 0) : 2;
+	int maxif=argc > 5 ? (int)strtol(argv[5], 0, 0) : 0x4000;
+	int epochs=argc > 6 ? atoi(argv[6]) : 1;
+	unsigned long seed=argc > 7 ? strtoul(argv[7], 0, 0) : 0;
+	int threads=argc > 8 ? atoi(argv[8]) : 0;
+
+	Clock::time_point start=Clock::now();
+	NeuroMemVectors vectors;
+	int error=vectors.read(argv[1], threads);
+	if (error==2)
+	{
+		fprintf(stderr, "cannot open %s\n", argv[1]);
+		return(2);
+	}
+	if (error!=0)
+	{
+		fprintf(stderr, "%s line %ld: %s\n", argv[1], vectors.line, vectors.message.c_str());
+		return(2);
+	}
+	size_t nvectors=vectors.size();
+	if (nvectors==0)
+	{
+		fprintf(stderr, "no vector in %s\n", argv[1]);
+		return(2);
+	}
+	printf("%lu vectors, %lu bytes parsed in %.2f s by %d threads%s\n", (unsigned long)nvectors,
+		(unsigned long)vectors.bytes, seconds(start), vectors.threads, vectors.counted ? ", vector length in the 5th column" : "");
+
+	// learn, epoch after epoch
+	NeuroMemEmu emu(capacity);
+	NeuroMemAI hNN;
+	if (hNN.begin(&emu)!=0) return(2);
+	std::vector<size_t> order(nvectors);
+	for (size_t i=0; i<nvectors; i++) order[i]=i;
+	std::mt19937 rng((unsigned)seed);
+	uint64_t previous=state(emu.neurons);
+	int vector[NeuroMemAI::NEURONSIZE];
+	for (int epoch=1; epoch<=epochs; epoch++)
+	{
+		start=Clock::now();
+		if (seed!=0) std::shuffle(order.begin(), order.end(), rng);
+		for (size_t i=0; i<nvectors; i++)
+		{
+			size_t v=order[i];
+			const uint8_t* comps=vectors.vector(v);
+			for (int j=0; j<vectors.length[v]; j++) vector[j]=comps[j];
+			hNN.setContext(vectors.context[v], minif, maxif); // no SPI access if it does not change
+			hNN.learn(vector, vectors.length[v], vectors.category[v]);
+		}
+		uint64_t current=state(emu.neurons);
+		printf("epoch %d: %d neurons committed in %.2f s\n", epoch, emu.neurons.count, seconds(start));
+		if (emu.neurons.count==capacity) printf("warning: the %d neurons are committed, the network is full\n", capacity);
+		if (current==previous)
+		{
+			printf("the neurons did not change\n");
+			break;
+		}
+		previous=current;
+	}
+
+	if (hNN.saveKnowledge_SDcard(argv[2])!=0)
+	{
+		fprintf(stderr, "cannot write %s\n", argv[2]);
+		return(2);
+	}
+	printf("%s saved\n", argv[2]);
+	return(0);
+}
@@ -0,0 +1,199 @@
+/************************************************************************/
+/*
+ *	compact_knowledge.cpp	--	Merge knowledge files and remove the redundant neurons
+ *
+ *  Merge the neurons of V2 knowledge files with NeuroMemCompactor, remove
+ *  the neurons shadowed by a neuron of the same category, then, with a
+ *  validation file of vectors (CSV format of the Knowledge Builder, see
+ *  NeuroMemVectors.h), the neurons which are the top firing neuron of none
+ *  of its vectors, and save the remaining neurons.
+ *
+ *  The merged and the compacted knowledge are then each loaded on a
+ *  NeuroShield modeled on the host (NeuroMemSPIDevice, with enough neurons
+ *  for the merged knowledge), to report the bus time of loadKnowledge_SDcard
+ *  and saveKnowledge_SDcard, and with the validation vectors, the bus time
+ *  of classify with K=10, the firing neurons per vector, and the vectors
+ *  whose top firing category is not the same after the compaction.
+ *
+ *  compact_knowledge output.knf input.knf [input.knf ...] [-v validation.txt]
+ *
+ *  From the NeuroMem folder:
+ *  g++ -O2 -std=c++11 -pthread -Iextras/host -I. extras/host/compact_knowledge.cpp extras/host/NeuroMemCompactor.cpp \
+ *      extras/host/NeuroMemVectors.cpp extras/host/NeuroMemKnowledgeMap.cpp NeuroMemAI.cpp NeuroMemSPI.cpp \
+ *      NeuroMemTrace.cpp NeuroMemKnowledge.cpp extras/host/NeuroMemSPIDevice.cpp extras/host/NeuroMemEmu.cpp \
+ *      extras/host/NeuroMemStore.cpp extras/host/NeuroMemKernels.cpp extras/host/ArduinoHost.cpp -o compact_knowledge
+ */
+/******************************************************************************/
+
+#include <NeuroMemAI.h>
+#include "NeuroMemCompactor.h"
+#include "NeuroMemKnowledgeMap.h"
+#include "NeuroMemEmu.h"
+#include "NeuroMemSPIDevice.h"
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+struct Measure
+{
+	int neurons=0;
+	double load=0, save=0, classify=0; // modeled bus time, us
+	double firing=0; // firing neurons per validation vector, up to K
+	std::vector<int> categories; // top firing category of the validation vectors
+};
+
+static const int K=10;
+
+// load a knowledge on the modeled NeuroShield, classify the validation vectors and save it
+static int measure(const char* filename, int capacity, const NeuroMemVectors* validation, Measure &m)
+{
+	NeuroMemEmu emu(capacity);
+	NeuroMemSPIDevice device(&emu);
+	SPI.attach(7, &device);
+	NeuroMemAI hNN;
+	int error=hNN.begin();
+	if (error==0)
+	{
+		std::vector<char> name(filename, filename + strlen(filename) + 1);
+		device.clearCounters();
+		error=hNN.loadKnowledge_SDcard(name.data());
+		m.load=device.busMicros;
+		m.neurons=hNN.NCOUNT();
+	}
+	if ((error==0) && (validation!=0))
+	{
+		int vector[NeuroMemAI::NEURONSIZE], distance[K], category[K], nid[K];
+		long firing=0;
+		device.clearCounters();
+		for (size_t v=0; v<validation->size(); v++)
+		{
+			for (int j=0; j<validation->length[v]; j++) vector[j]=validation->vector(v)[j];
+			hNN.GCR(validation->context[v]);
+			firing+=hNN.classify(vector, validation->length[v], K, distance, category, nid);
+			m.categories.push_back(category[0]==0xFFFF ? 0xFFFF : category[0] & 0x7FFF);
+		}
+		m.classify=validation->size() > 0 ? device.busMicros / validation->size() : 0;
+		m.firing=validation->size() > 0 ? (double)firing / validation->size() : 0;
+	}
+	if (error==0)
+	{
+		char temp[]="/tmp/compact_knowledgeXXXXXX";
+		int fd=mkstemp(temp);
+		if (fd >= 0)
+		{
+			::close(fd);
+			device.clearCounters();
+			hNN.saveKnowledge_SDcard(temp);
+			m.save=device.busMicros;
+			unlink(temp);
+		}
+	}
+	SPI.attach(7, 0);
+	return(error);
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<const char*> inputs;
+	const char* output=0;
+	const char* validationFile=0;
+	for (int i=1; i<argc; i++)
+	{
+		if ((strcmp(argv[i], "-v")==0) && (i + 1 < argc)) validationFile=argv[++i];
+		else if (output==0) output=argv[i];
+		else inputs.push_back(argv[i]);
+	}
+	if ((output==0) || (inputs.empty()))
+	{
+		fprintf(stderr, "compact_knowledge output.knf input.knf [input.knf ...] [-v validation.txt]\n");
+		return(2);
+	}
+
+	// capacity for all the neurons of the inputs
+	int capacity=0;
+	for (size_t i=0; i<inputs.size(); i++)
+	{
+		NeuroMemKnowledgeMap knowledge;
+		int error=knowledge.open(inputs[i]);
+		if (error!=0)
+		{
+			fprintf(stderr, "cannot read %s (error %d)\n", inputs[i], error);
+			return(2);
+		}
+		capacity+=knowledge.size();
+	}
+	NeuroMemCompactor compactor(capacity > 0 ? capacity : 1);
+	for (size_t i=0; i<inputs.size(); i++)
+	{
+		int error=compactor.merge(inputs[i]);
+		if (error!=0)
+		{
+			fprintf(stderr, "cannot merge %s (error %d)\n", inputs[i], error);
+			return(2);
+		}
+	}
+	int merged=compactor.neurons.count;
+	char mergedFile[]="/tmp/compact_mergedXXXXXX";
+	int fd=mkstemp(mergedFile);
+	if ((fd < 0) || (compactor.save(mergedFile)!=0))
+	{
+		fprintf(stderr, "cannot write a temporary file\n");
+		return(2);
+	}
+	::close(fd);
+
+	NeuroMemVectors validation;
+	if (validationFile!=0)
+	{
+		int error=validation.read(validationFile);
+		if (error!=0)
+		{
+			fprintf(stderr, "%s line %ld: %s\n", validationFile, validation.line, validation.message.c_str());
+			unlink(mergedFile);
+			return(2);
+		}
+	}
+
+	int shadowed=compactor.removeShadowed();
+	int unused=validationFile!=0 ? compactor.removeUnused(validation) : 0;
+	if (compactor.save(output)!=0)
+	{
+		fprintf(stderr, "cannot write %s\n", output);
+		unlink(mergedFile);
+		return(2);
+	}
+	printf("%d neurons merged from %d files, %d shadowed", merged, (int)inputs.size(), shadowed);
+	if (validationFile!=0) printf(", %d top firing neuron of no validation vector", unused);
+	printf(", %d neurons saved in %s (-%.0f%%)\n", compactor.neurons.count, output,
+		merged > 0 ? 100.0 * (merged - compactor.neurons.count) / merged : 0.0);
+
+	// before and after on the modeled NeuroShield
+	Measure before, after;
+	int device=merged > 576 ? merged : 576;
+	const NeuroMemVectors* vectors=validationFile!=0 ? &validation : 0;
+	int error=measure(mergedFile, device, vectors, before);
+	if (error==0) error=measure(output, device, vectors, after);
+	unlink(mergedFile);
+	if (error!=0)
+	{
+		fprintf(stderr, "cannot load the knowledge (error %d)\n", error);
+		return(2);
+	}
+	printf("NeuroShield bus time, merged -> compacted:\n");
+	printf("  loadKnowledge_SDcard %.0f -> %.0f ms (x%.2f)\n", before.load / 1000, after.load / 1000,
+		after.load > 0 ? before.load / after.load : 0.0);
+	printf("  saveKnowledge_SDcard %.0f -> %.0f ms (x%.2f)\n", before.save / 1000, after.save / 1000,
+		after.save > 0 ? before.save / after.save : 0.0);
+	if (validationFile!=0)
+	{
+		int changed=0;
+		for (size_t v=0; v<validation.size(); v++) changed+=before.categories[v]!=after.categories[v] ? 1 : 0;
+		printf("  classify K=%d %.0f -> %.0f us per vector, %.1f -> %.1f firing neurons\n", K, before.classify,
+			after.classify, before.firing, after.firing);
+		printf("%d of %lu validation vectors changed of top firing category\n", changed, (unsigned long)validation.size());
+	}
+	return(0);
+}
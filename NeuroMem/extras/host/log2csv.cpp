@@ -0,0 +1,143 @@
+/************************************************************************/
+/*
+ *	log2csv.cpp	--	Convert a log of training samples to CSV and images
+ *
+ *  Read a log file written by NeuroMemLogger (.nml), write its vectors in
+ *  the CSV format of the NeuroMem Knowledge Builder, as saveVectors did in
+ *  the example, with the vector length before the components:
+ *
+ *    patternID, parentID, Context, GTcategory, v1
+ *
+ *  and, with a prefix, each frame to a PPM image <prefix><ID>cat<category>.ppm,
+ *  its RGB565 pixels expanded to 8 bits per color.
+ *  The ID is the number of the record in the file, from 0, so a frame
+ *  logged after its vector has the next ID. The output is readable by
+ *  build_knowledge. A record of an unknown kind is reported and skipped
+ *  with its length. A record cut at the end of the file, for example by
+ *  a power loss during the logging, is reported and ignored.
+ *
+ *  log2csv SAMPLE00.NML vectors.txt [frames/img]
+ *
+ *  From the NeuroMem folder:
+ *  g++ -O2 -std=c++11 -Iextras/host -I. extras/host/log2csv.cpp NeuroMemKnowledge.cpp -o log2csv
+ */
+/******************************************************************************/
+
+#include <NeuroMemLogger.h>
+#include <NeuroMemKnowledge.h>
+#include <NeuroMemFeatures.h>
+
+#include <vector>
+#include <stdio.h>
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		fprintf(stderr, "log2csv SAMPLE00.NML vectors.txt [frames/img]\n");
+		return(2);
+	}
+	const char* prefix=argc > 3 ? argv[3] : 0;
+	FILE* f=fopen(argv[1], "rb");
+	if (f==0)
+	{
+		fprintf(stderr, "cannot read %s\n", argv[1]);
+		return(2);
+	}
+	uint8_t header[NeuroMemLogger::HEADER_SIZE];
+	if ((fread(header, 1, sizeof(header), f)!=sizeof(header)) || (NeuroMemKnowledge::get16(header)!=NeuroMemLogger::FORMAT))
+	{
+		fprintf(stderr, "%s is not a log file\n", argv[1]);
+		fclose(f);
+		return(2);
+	}
+	FILE* csv=fopen(argv[2], "w");
+	if (csv==0)
+	{
+		fprintf(stderr, "cannot write %s\n", argv[2]);
+		fclose(f);
+		return(2);
+	}
+	fprintf(csv, "patternID, parentID, Context, GTcategory, v1\n");
+	fseek(f, 0, SEEK_END);
+	long end=ftell(f);
+	fseek(f, NeuroMemLogger::HEADER_SIZE, SEEK_SET);
+
+	long id=0, vectors=0, frames=0, skipped=0;
+	long offset=NeuroMemLogger::HEADER_SIZE;
+	int status=0;
+	std::vector<uint8_t> record;
+	uint8_t prefixed[4];
+	size_t n;
+	while ((n=fread(prefixed, 1, 4, f)) > 0)
+	{
+		uint32_t length=NeuroMemKnowledge::get32(prefixed);
+		const char* error=0;
+		if (n < 4) error="record cut at the end of the file";
+		else if (length < NeuroMemLogger::RECORD_SIZE - 4) error="bad record length";
+		else if ((long)length > end - offset - 4) error="record cut at the end of the file";
+		else
+		{
+			record.resize(length);
+			if (fread(record.data(), 1, length, f)!=length) error="record cut at the end of the file";
+		}
+		int kind=error==0 ? record[0] : 0;
+		int context=error==0 ? record[1] : 0;
+		int category=error==0 ? NeuroMemKnowledge::get16(&record[2]) : 0;
+		const uint8_t* data=error==0 ? &record[8] : 0;
+		long size=(long)length - 8;
+		if ((error==0) && (kind==NeuroMemLogger::VECTOR))
+		{
+			fprintf(csv, "%ld,0,%d,%d,%ld,", id, context, category, size);
+			for (long i=0; i<size; i++) fprintf(csv, "%d,", data[i]);
+			fprintf(csv, "\n");
+			vectors++;
+		}
+		else if ((error==0) && (kind==NeuroMemLogger::FRAME))
+		{
+			int width=size >= 4 ? NeuroMemKnowledge::get16(data) : 0;
+			int height=size >= 4 ? NeuroMemKnowledge::get16(data + 2) : 0;
+			if ((size < 4) || ((long)width * height * 2!=size - 4)) error="bad frame size";
+			else if (prefix!=0)
+			{
+				char name[1024];
+				snprintf(name, sizeof(name), "%s%ldcat%d.ppm", prefix, id, category);
+				FILE* ppm=fopen(name, "wb");
+				if (ppm==0)
+				{
+					fprintf(stderr, "cannot write %s\n", name);
+					status=2;
+					break;
+				}
+				fprintf(ppm, "P6\n%d %d\n255\n", width, height);
+				for (const uint8_t* pixel=data + 4; pixel<data + size; pixel+=2)
+				{
+					int r=NeuroMemRGB565::red(pixel), g=NeuroMemRGB565::green(pixel), b=NeuroMemRGB565::blue(pixel);
+					fputc((r << 3) | (r >> 2), ppm);
+					fputc((g << 2) | (g >> 4), ppm);
+					fputc((b << 3) | (b >> 2), ppm);
+				}
+				fclose(ppm);
+			}
+			if (error==0) frames++;
+		}
+		else if (error==0)
+		{
+			// a kind added after this converter: its length still gives the next record
+			fprintf(stderr, "%s offset %ld: unknown kind of record %d, ignored\n", argv[1], offset, kind);
+			skipped++;
+		}
+		if (error!=0)
+		{
+			fprintf(stderr, "%s offset %ld: %s, the next records are ignored\n", argv[1], offset, error);
+			status=1;
+			break;
+		}
+		offset+=4 + length;
+		id++;
+	}
+	fclose(f);
+	fclose(csv);
+	printf("%ld vectors, %ld frames, %ld records of unknown kinds\n", vectors, frames, skipped);
+	return(status);
+}
@@ -0,0 +1,173 @@
+/************************************************************************/
+/*																		
+ *	replay_trace.cpp	--	Replay a trace of SPI transactions on a software network
+ *
+ *  Read a trace file recorded by NeuroMemTrace (.nmt), send its transactions
+ *  through NeuroMemSPI to an emulated network (NeuroMemSPIDevice and
+ *  NeuroMemEmu), verify that the words read are the words recorded, and
+ *  report per function of NeuroMemAI the number of calls, transactions and
+ *  bytes, the time recorded on the board and the modeled bus time.
+ *  The transactions outside the functions, for example the register access
+ *  functions of NeuroMemAI, are reported as "registers".
+ *  The trace must start on a network in its power-on state, for example
+ *  with spi.trace set after hNN.begin(), and without records dropped.
+ *  Output in CSV format:
+ *  operation,calls,transactions,bytes,recorded_us,modeled_us
+ *
+ *  replay_trace file.nmt [neurons=576] [clock=2000000]
+ *
+ *  From the NeuroMem folder:
+ *  g++ -O2 -std=c++11 -Iextras/host -I. extras/host/replay_trace.cpp NeuroMemSPI.cpp NeuroMemTrace.cpp \
+ *      NeuroMemKnowledge.cpp extras/host/NeuroMemSPIDevice.cpp extras/host/NeuroMemEmu.cpp \
+ *      extras/host/NeuroMemStore.cpp extras/host/NeuroMemKernels.cpp extras/host/ArduinoHost.cpp -o replay_trace
+ */
+/******************************************************************************/
+
+#include <NeuroMemSPI.h>
+#include <NeuroMemTrace.h>
+#include <NeuroMemKnowledge.h>
+#include "NeuroMemEmu.h"
+#include "NeuroMemSPIDevice.h"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct Operation
+{
+	long calls=0;
+	unsigned long transactions=0;
+	unsigned long bytes=0;
+	double recorded=0;
+	double modeled=0;
+};
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "replay_trace file.nmt [neurons=576] [clock=2000000]\n");
+		return(2);
+	}
+	int neurons=argc > 2 ? atoi(argv[2]) : 576;
+	long clock=argc > 3 ? atol(argv[3]) : 2000000;
+	FILE* f=fopen(argv[1], "rb");
+	if (f==0)
+	{
+		fprintf(stderr, "cannot open %s\n", argv[1]);
+		return(2);
+	}
+	std::vector<uint8_t> trace;
+	uint8_t chunk[4096];
+	size_t n;
+	while ((n=fread(chunk, 1, sizeof(chunk), f)) > 0) trace.insert(trace.end(), chunk, chunk + n);
+	fclose(f);
+	if ((trace.size() < (size_t)NeuroMemTrace::HEADER_SIZE) || (NeuroMemKnowledge::get16(&trace[0])!=NeuroMemTrace::FORMAT))
+	{
+		fprintf(stderr, "%s is not a trace file\n", argv[1]);
+		return(2);
+	}
+	unsigned long dropped=NeuroMemKnowledge::get32(&trace[4]);
+	if (dropped > 0) fprintf(stderr, "warning: %lu records dropped, the responses cannot be verified\n", dropped);
+
+	// NeuroShield chip select, without the reset delays of the other platforms
+	NeuroMemEmu emu(neurons);
+	NeuroMemSPIDevice device(&emu);
+	SPI.attach(7, &device);
+	NeuroMemSPI spi;
+	if (spi.connect(2)!=0) return(2);
+	spi.speed=clock;
+	device.clearCounters();
+
+	std::map<std::string, Operation> operations;
+	std::string current="registers";
+	unsigned long startTime=0, lastTime=0;
+	unsigned long startTransactions=0, startBytes=0;
+	double startMicros=0;
+	long records=0, mismatches=0;
+	std::vector<int> words, read;
+	size_t pos=NeuroMemTrace::HEADER_SIZE;
+	while (pos + NeuroMemTrace::RECORD_SIZE <= trace.size())
+	{
+		const uint8_t* record=&trace[pos];
+		uint8_t kind=record[0];
+		uint8_t mod=record[1];
+		uint8_t reg=record[2];
+		int length=NeuroMemKnowledge::get16(record + 3);
+		unsigned long time=NeuroMemKnowledge::get32(record + 5);
+		size_t payload=(kind==NeuroMemTrace::MARK) ? length : 2 * length;
+		if (pos + NeuroMemTrace::RECORD_SIZE + payload > trace.size()) break;
+		const uint8_t* data=record + NeuroMemTrace::RECORD_SIZE;
+		pos+=NeuroMemTrace::RECORD_SIZE + payload;
+		records++;
+
+		if (kind==NeuroMemTrace::MARK)
+		{
+			// close the current function and start the next one
+			Operation &op=operations[current];
+			if (current!="registers")
+			{
+				op.calls++;
+				op.recorded+=(double)(time - startTime);
+			}
+			op.transactions+=device.transactions - startTransactions;
+			op.bytes+=device.bytes - startBytes;
+			op.modeled+=device.busMicros - startMicros;
+			current=(length > 0) ? std::string((const char*)data, length) : std::string("registers");
+			startTime=time;
+			startTransactions=device.transactions;
+			startBytes=device.bytes;
+			startMicros=device.busMicros;
+			continue;
+		}
+		lastTime=time;
+		words.resize(length);
+		read.resize(length);
+		for (int i=0; i<length; i++) words[i]=NeuroMemKnowledge::get16(data + 2 * i);
+		long addr=((long)mod << 24) + reg;
+		switch (kind)
+		{
+			case NeuroMemTrace::READ: read[0]=spi.read(mod, reg); break;
+			case NeuroMemTrace::WRITE: spi.write(mod, reg, words[0]); break;
+			case NeuroMemTrace::READ_ADDR: spi.readAddr(addr, length, read.data()); break;
+			case NeuroMemTrace::WRITE_ADDR: spi.writeAddr(addr, length, words.data()); break;
+			default:
+				fprintf(stderr, "unknown record %d at byte %lu\n", kind, (unsigned long)(pos - payload - NeuroMemTrace::RECORD_SIZE));
+				return(2);
+		}
+		if ((kind==NeuroMemTrace::READ) || (kind==NeuroMemTrace::READ_ADDR))
+		{
+			for (int i=0; i<length; i++)
+			{
+				if (read[i]==words[i]) continue;
+				if (mismatches < 10)
+				{
+					fprintf(stderr, "record %ld (%s), module %d register %d word %d: read 0x%04X, recorded 0x%04X\n",
+						records, current.c_str(), mod, reg, i, read[i], words[i]);
+				}
+				mismatches++;
+			}
+		}
+	}
+	Operation &op=operations[current];
+	if (current!="registers")
+	{
+		op.calls++;
+		op.recorded+=(double)(lastTime - startTime);
+	}
+	op.transactions+=device.transactions - startTransactions;
+	op.bytes+=device.bytes - startBytes;
+	op.modeled+=device.busMicros - startMicros;
+
+	printf("operation,calls,transactions,bytes,recorded_us,modeled_us\n");
+	for (std::map<std::string, Operation>::iterator i=operations.begin(); i!=operations.end(); ++i)
+	{
+		Operation &o=i->second;
+		if ((o.calls==0) && (o.transactions==0)) continue;
+		printf("%s,%ld,%lu,%lu,%.0f,%.0f\n", i->first.c_str(), o.calls, o.transactions, o.bytes, o.recorded, o.modeled);
+	}
+	fprintf(stderr, "%ld records, %ld words differ\n", records, mismatches);
+	return(mismatches > 0 ? 1 : 0);
+}
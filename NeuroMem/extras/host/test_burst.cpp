@@ -0,0 +1,98 @@
+/************************************************************************/
+/*
+ *	test_burst.cpp	--	Bus bytes of broadcast with and without bursts
+ *
+ *  Count the bytes and transactions on the SPI bus (NeuroMemSPIDevice on
+ *  an emulated NeuroShield) of classify and learn, once with the
+ *  components written one register write each (hNN.burst=false) and once
+ *  with a Write_Addr burst, for vectors of 3 to 256 components. Fail when
+ *  the burst does not send fewer bytes, or when the answers differ.
+ *
+ *  test_burst, returns 0 if passed, 1 if failed
+ *
+ *  From the NeuroMem folder:
+ *  g++ -O2 -std=c++11 -Iextras/host -I. extras/host/test_burst.cpp NeuroMemAI.cpp NeuroMemSPI.cpp NeuroMemTrace.cpp \
+ *      NeuroMemKnowledge.cpp extras/host/NeuroMemSPIDevice.cpp extras/host/NeuroMemEmu.cpp \
+ *      extras/host/NeuroMemStore.cpp extras/host/NeuroMemKernels.cpp extras/host/ArduinoHost.cpp -o test_burst
+ */
+/******************************************************************************/
+
+#include <NeuroMemAI.h>
+#include "NeuroMemEmu.h"
+#include "NeuroMemSPIDevice.h"
+
+#include <vector>
+#include <stdio.h>
+
+static const int VECTORS=20;
+
+struct Count
+{
+	unsigned long bytes=0, transactions=0;
+	std::vector<int> answers; // nsr, distance, category, nid of each classify
+	int ncount=0;
+};
+
+// learn, then classify the vectors, and count the bus traffic of each
+static void run(bool burst, int length, Count &learnCount, Count &classifyCount)
+{
+	NeuroMemEmu emu(576);
+	NeuroMemSPIDevice device(&emu);
+	SPI.attach(7, &device);
+	NeuroMemAI hNN;
+	hNN.burst=burst;
+	hNN.begin();
+	std::vector<int> vector(length);
+	unsigned long seed=length;
+	device.clearCounters();
+	for (int v=0; v<VECTORS; v++)
+	{
+		for (int j=0; j<length; j++) vector[j]=(int)((seed=seed * 1103515245 + 12345) >> 16) & 0xFF;
+		learnCount.ncount=hNN.learn(vector.data(), length, 1 + v % 4);
+	}
+	learnCount.bytes=device.bytes;
+	learnCount.transactions=device.transactions;
+	device.clearCounters();
+	for (int v=0; v<VECTORS; v++)
+	{
+		for (int j=0; j<length; j++) vector[j]=(int)((seed=seed * 1103515245 + 12345) >> 16) & 0xFF;
+		int distance, category, nid;
+		int nsr=hNN.classify(vector.data(), length, &distance, &category, &nid);
+		classifyCount.answers.push_back(nsr);
+		classifyCount.answers.push_back(distance);
+		classifyCount.answers.push_back(category);
+		classifyCount.answers.push_back(nid);
+	}
+	classifyCount.bytes=device.bytes;
+	classifyCount.transactions=device.transactions;
+	SPI.attach(7, 0);
+}
+
+int main()
+{
+	static const int lengths[5]={ 3, 16, 64, 128, 256 };
+	int failed=0;
+	printf("length,operation,bytes_per_call,bytes_per_call_burst,transactions_per_call,transactions_per_call_burst\n");
+	for (int l=0; l<5; l++)
+	{
+		Count learnWords, classifyWords, learnBurst, classifyBurst;
+		run(false, lengths[l], learnWords, classifyWords);
+		run(true, lengths[l], learnBurst, classifyBurst);
+		printf("%d,learn,%lu,%lu,%lu,%lu\n", lengths[l], learnWords.bytes / VECTORS, learnBurst.bytes / VECTORS,
+			learnWords.transactions / VECTORS, learnBurst.transactions / VECTORS);
+		printf("%d,classify,%lu,%lu,%lu,%lu\n", lengths[l], classifyWords.bytes / VECTORS, classifyBurst.bytes / VECTORS,
+			classifyWords.transactions / VECTORS, classifyBurst.transactions / VECTORS);
+		if ((learnBurst.bytes >= learnWords.bytes) || (classifyBurst.bytes >= classifyWords.bytes))
+		{
+			printf("FAILED length %d: the burst does not send fewer bytes\n", lengths[l]);
+			failed++;
+		}
+		if ((learnBurst.ncount!=learnWords.ncount) || (classifyBurst.answers!=classifyWords.answers))
+		{
+			printf("FAILED length %d: the answers differ with the burst\n", lengths[l]);
+			failed++;
+		}
+	}
+	printf(failed==0 ? "passed\n" : "%d failed\n", failed);
+	return(failed==0 ? 0 : 1);
+}
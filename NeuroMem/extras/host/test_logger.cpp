@@ -0,0 +1,177 @@
+/************************************************************************/
+/*
+ *	test_logger.cpp	--	Logs of the training samples cut by a power loss
+ *
+ *  Write logs through NeuroMemLogger to files of the current directory,
+ *  and check the records read back:
+ *    - a second session appends to a complete log, and keeps its records
+ *    - begin() returns 5 for a log cut inside its last record, as after
+ *      a power loss, and the file is not appended to
+ *    - the next log, as numbered by the example, is complete
+ *    - begin() returns 4 for a file which is not a log
+ *
+ *  test_logger, returns 0 if passed, 1 if failed
+ *
+ *  From the NeuroMem folder:
+ *  g++ -O2 -std=c++11 -Iextras/host -I. extras/host/test_logger.cpp NeuroMemLogger.cpp NeuroMemKnowledge.cpp \
+ *      extras/host/ArduinoHost.cpp -o test_logger
+ */
+/******************************************************************************/
+
+#include <NeuroMemLogger.h>
+#include <NeuroMemKnowledge.h>
+
+#include <vector>
+#include <stdio.h>
+#include <unistd.h>
+
+static const int SESSION=10; // vectors per session
+static const int FRAME_WIDTH=8, FRAME_HEIGHT=4;
+
+static int failed=0;
+
+static void check(bool passed, const char* what)
+{
+	if (passed) return;
+	printf("FAILED %s\n", what);
+	failed++;
+}
+
+// components, category and time of the vector number n of the logs
+static int vectorLength(int n) { return(8 + n % 24); }
+static int component(int n, int j) { return((n * 7 + j) & 0xFF); }
+
+// log the vectors first..first+SESSION-1, with a frame after the first one
+static int logSession(const char* filename, int first)
+{
+	uint8_t buffer[512];
+	NeuroMemLogger logger(buffer, sizeof(buffer));
+	int status=logger.begin(filename);
+	if (status!=0) return(status);
+	int vector[256];
+	uint8_t line[FRAME_WIDTH * 2]; // RGB565
+	for (int n=first; n<first + SESSION; n++)
+	{
+		for (int j=0; j<vectorLength(n); j++) vector[j]=component(n, j);
+		logger.logVector(vector, vectorLength(n), 1 + n % 4, 1, 1000 + n);
+		if (n==first)
+		{
+			logger.beginFrame(FRAME_WIDTH, FRAME_HEIGHT, 1 + n % 4, 1, 1000 + n);
+			for (int y=0; y<FRAME_HEIGHT; y++)
+			{
+				for (int x=0; x<FRAME_WIDTH * 2; x++) line[x]=(uint8_t)(n + x * y);
+				logger.addLine(line);
+			}
+		}
+	}
+	return(logger.end());
+}
+
+// --------------------------------------------------------
+// Read a log, and check its vectors 0..vectors-1 and their frames
+// Return the number of complete records, and cut if the file ends inside one
+//---------------------------------------------------------
+static int readLog(const char* filename, int vectors, bool* cut)
+{
+	*cut=false;
+	FILE* f=fopen(filename, "rb");
+	if (f==0) return(-1);
+	std::vector<uint8_t> data;
+	int c;
+	while ((c=fgetc(f))!=EOF) data.push_back((uint8_t)c);
+	fclose(f);
+	if ((data.size() < NeuroMemLogger::HEADER_SIZE) || (NeuroMemKnowledge::get16(&data[0])!=NeuroMemLogger::FORMAT)) return(-1);
+	size_t position=NeuroMemLogger::HEADER_SIZE;
+	int records=0, n=0;
+	while (position < data.size())
+	{
+		if (data.size() - position < 4) { *cut=true; break; }
+		uint32_t length=NeuroMemKnowledge::get32(&data[position]);
+		if (length > data.size() - position - 4) { *cut=true; break; }
+		const uint8_t* record=&data[position];
+		uint8_t kind=record[4];
+		int category=NeuroMemKnowledge::get16(record + 6);
+		bool same=(n < vectors);
+		if (kind==NeuroMemLogger::VECTOR)
+		{
+			same=same && ((int)length==NeuroMemLogger::RECORD_SIZE - 4 + vectorLength(n)) && (category==1 + n % 4)
+				&& (NeuroMemKnowledge::get32(record + 8)==(uint32_t)(1000 + n));
+			for (int j=0; same && (j<vectorLength(n)); j++) same=(record[NeuroMemLogger::RECORD_SIZE + j]==component(n, j));
+			n++;
+		}
+		else
+		{
+			// the frame follows the first vector of a session
+			int m=n - 1;
+			const uint8_t* frame=record + NeuroMemLogger::RECORD_SIZE;
+			same=(kind==NeuroMemLogger::FRAME) && (m % SESSION==0) && (category==1 + m % 4)
+				&& ((int)length==NeuroMemLogger::RECORD_SIZE - 4 + 4 + FRAME_WIDTH * FRAME_HEIGHT * 2)
+				&& (NeuroMemKnowledge::get16(frame)==FRAME_WIDTH) && (NeuroMemKnowledge::get16(frame + 2)==FRAME_HEIGHT);
+			for (int y=0; same && (y<FRAME_HEIGHT); y++)
+				for (int x=0; same && (x<FRAME_WIDTH * 2); x++) same=(frame[4 + y * FRAME_WIDTH * 2 + x]==(uint8_t)(m + x * y));
+		}
+		if (!same)
+		{
+			printf("%s: record %d differs\n", filename, records);
+			return(-1);
+		}
+		records++;
+		position+=4 + length;
+	}
+	return(records);
+}
+
+static long fileSize(const char* filename)
+{
+	FILE* f=fopen(filename, "rb");
+	if (f==0) return(-1);
+	fseek(f, 0, SEEK_END);
+	long size=ftell(f);
+	fclose(f);
+	return(size);
+}
+
+int main()
+{
+	const char* first="TEST00.NML";
+	const char* next="TEST01.NML";
+	const char* other="TEST02.NML";
+	remove(first);
+	remove(next);
+	remove(other);
+	bool cut;
+
+	// two sessions append to the same log
+	check(logSession(first, 0)==0, "begin of a new log");
+	check(readLog(first, SESSION, &cut)==SESSION + 1 && !cut, "records of the first session");
+	check(logSession(first, SESSION)==0, "begin of a complete log");
+	check(readLog(first, 2 * SESSION, &cut)==2 * SESSION + 2 && !cut, "records of the second session, after the first one");
+
+	// a power loss cuts the last record
+	long size=fileSize(first);
+	check(truncate(first, size - 3)==0, "truncate");
+	check(logSession(first, 2 * SESSION)==5, "begin returns 5 for a cut log");
+	check(fileSize(first)==size - 3, "a cut log is not appended to");
+	check(readLog(first, 2 * SESSION, &cut)==2 * SESSION + 1 && cut, "records before the cut");
+
+	// a cut inside the length of the last record
+	check(truncate(first, NeuroMemLogger::HEADER_SIZE + 2)==0, "truncate");
+	check(logSession(first, 0)==5, "begin returns 5 for a log cut inside a length");
+
+	// the next log
+	check(logSession(next, 0)==0, "begin of the next log");
+	check(readLog(next, SESSION, &cut)==SESSION + 1 && !cut, "records of the next log");
+
+	// a file which is not a log
+	FILE* f=fopen(other, "wb");
+	fputs("category,vector\n", f);
+	fclose(f);
+	check(logSession(other, 0)==4, "begin returns 4 for a file which is not a log");
+	check(fileSize(other)==16, "a file which is not a log is not appended to");
+
+	remove(first);
+	remove(next);
+	remove(other);
+	printf(failed==0 ? "passed\n" : "%d failed\n", failed);
+	return(failed==0 ? 0 : 1);
+}